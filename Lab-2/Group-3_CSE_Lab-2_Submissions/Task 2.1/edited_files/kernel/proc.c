@@ -1,706 +1,1392 @@
-#include "types.h"
-#include "param.h"
-#include "memlayout.h"
-#include "riscv.h"
-#include "spinlock.h"
-#include "proc.h"
-#include "defs.h"
-
-struct cpu cpus[NCPU];
-
-struct proc proc[NPROC];
-
-struct proc *initproc;
-
-int nextpid = 1;
-struct spinlock pid_lock;
-
-extern void forkret(void);
-static void freeproc(struct proc *p);
-
-extern char trampoline[]; // trampoline.S
-
-// helps ensure that wakeups of wait()ing
-// parents are not lost. helps obey the
-// memory model when using p->parent.
-// must be acquired before any p->lock.
-struct spinlock wait_lock;
-
-// Allocate a page for each process's kernel stack.
-// Map it high in memory, followed by an invalid
-// guard page.
-void
-proc_mapstacks(pagetable_t kpgtbl)
-{
-  struct proc *p;
-  
-  for(p = proc; p < &proc[NPROC]; p++) {
-    char *pa = kalloc();
-    if(pa == 0)
-      panic("kalloc");
-    uint64 va = KSTACK((int) (p - proc));
-    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
-  }
-}
-
-// initialize the proc table.
-void
-procinit(void)
-{
-  struct proc *p;
-  
-  initlock(&pid_lock, "nextpid");
-  initlock(&wait_lock, "wait_lock");
-  for(p = proc; p < &proc[NPROC]; p++) {
-      initlock(&p->lock, "proc");
-      p->state = UNUSED;
-      p->kstack = KSTACK((int) (p - proc));
-  }
-}
-
-// Must be called with interrupts disabled,
-// to prevent race with process being moved
-// to a different CPU.
-int
-cpuid()
-{
-  int id = r_tp();
-  return id;
-}
-
-// Return this CPU's cpu struct.
-// Interrupts must be disabled.
-struct cpu*
-mycpu(void)
-{
-  int id = cpuid();
-  struct cpu *c = &cpus[id];
-  return c;
-}
-
-// Return the current struct proc *, or zero if none.
-struct proc*
-myproc(void)
-{
-  push_off();
-  struct cpu *c = mycpu();
-  struct proc *p = c->proc;
-  pop_off();
-  return p;
-}
-
-int
-allocpid()
-{
-  int pid;
-  
-  acquire(&pid_lock);
-  pid = nextpid;
-  nextpid = nextpid + 1;
-  release(&pid_lock);
-
-  return pid;
-}
-
-// Look in the process table for an UNUSED proc.
-// If found, initialize state required to run in the kernel,
-// and return with p->lock held.
-// If there are no free procs, or a memory allocation fails, return 0.
-static struct proc*
-allocproc(void)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->state == UNUSED) {
-      goto found;
-    } else {
-      release(&p->lock);
-    }
-  }
-  return 0;
-
-found:
-  p->pid = allocpid();
-  p->state = USED;
-
-  // Task 2.1
-  p->priority = DEFAULT_PRIORITY;
-  p->ticks = 0;
-
-  // Allocate a trapframe page.
-  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // An empty user page table.
-  p->pagetable = proc_pagetable(p);
-  if(p->pagetable == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // Set up new context to start executing at forkret,
-  // which returns to user space.
-  memset(&p->context, 0, sizeof(p->context));
-  p->context.ra = (uint64)forkret;
-  p->context.sp = p->kstack + PGSIZE;
-
-  return p;
-}
-
-// free a proc structure and the data hanging from it,
-// including user pages.
-// p->lock must be held.
-static void
-freeproc(struct proc *p)
-{
-  if(p->trapframe)
-    kfree((void*)p->trapframe);
-  p->trapframe = 0;
-  if(p->pagetable)
-    proc_freepagetable(p->pagetable, p->sz);
-  p->pagetable = 0;
-  p->sz = 0;
-  p->pid = 0;
-  p->parent = 0;
-  p->name[0] = 0;
-  p->chan = 0;
-  p->killed = 0;
-  p->xstate = 0;
-  p->state = UNUSED;
-}
-
-// Create a user page table for a given process, with no user memory,
-// but with trampoline and trapframe pages.
-pagetable_t
-proc_pagetable(struct proc *p)
-{
-  pagetable_t pagetable;
-
-  // An empty page table.
-  pagetable = uvmcreate();
-  if(pagetable == 0)
-    return 0;
-
-  // map the trampoline code (for system call return)
-  // at the highest user virtual address.
-  // only the supervisor uses it, on the way
-  // to/from user space, so not PTE_U.
-  if(mappages(pagetable, TRAMPOLINE, PGSIZE,
-              (uint64)trampoline, PTE_R | PTE_X) < 0){
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  // map the trapframe page just below the trampoline page, for
-  // trampoline.S.
-  if(mappages(pagetable, TRAPFRAME, PGSIZE,
-              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
-    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  return pagetable;
-}
-
-// Free a process's page table, and free the
-// physical memory it refers to.
-void
-proc_freepagetable(pagetable_t pagetable, uint64 sz)
-{
-  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-  uvmunmap(pagetable, TRAPFRAME, 1, 0);
-  uvmfree(pagetable, sz);
-}
-
-// a user program that calls exec("/init")
-// assembled from ../user/initcode.S
-// od -t xC ../user/initcode
-uchar initcode[] = {
-  0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0x45, 0x02,
-  0x97, 0x05, 0x00, 0x00, 0x93, 0x85, 0x35, 0x02,
-  0x93, 0x08, 0x70, 0x00, 0x73, 0x00, 0x00, 0x00,
-  0x93, 0x08, 0x20, 0x00, 0x73, 0x00, 0x00, 0x00,
-  0xef, 0xf0, 0x9f, 0xff, 0x2f, 0x69, 0x6e, 0x69,
-  0x74, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00
-};
-
-// Set up first user process.
-void
-userinit(void)
-{
-  struct proc *p;
-
-  p = allocproc();
-  initproc = p;
-  
-  // allocate one user page and copy initcode's instructions
-  // and data into it.
-  uvmfirst(p->pagetable, initcode, sizeof(initcode));
-  p->sz = PGSIZE;
-
-  // prepare for the very first "return" from kernel to user.
-  p->trapframe->epc = 0;      // user program counter
-  p->trapframe->sp = PGSIZE;  // user stack pointer
-
-  safestrcpy(p->name, "initcode", sizeof(p->name));
-  p->cwd = namei("/");
-
-  p->state = RUNNABLE;
-
-  release(&p->lock);
-}
-
-// Grow or shrink user memory by n bytes.
-// Return 0 on success, -1 on failure.
-int
-growproc(int n)
-{
-  uint64 sz;
-  struct proc *p = myproc();
-
-  sz = p->sz;
-  if(n > 0){
-    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
-      return -1;
-    }
-  } else if(n < 0){
-    sz = uvmdealloc(p->pagetable, sz, sz + n);
-  }
-  p->sz = sz;
-  return 0;
-}
-
-// Create a new process, copying the parent.
-// Sets up child kernel stack to return as if from fork() system call.
-int
-fork(void)
-{
-  int i, pid;
-  struct proc *np;
-  struct proc *p = myproc();
-
-  // Allocate process.
-  if((np = allocproc()) == 0){
-    return -1;
-  }
-
-  // Task 2.1
-  np->priority = p->priority;
-  np->ticks = 0;
-
-  // Copy user memory from parent to child.
-  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
-    freeproc(np);
-    release(&np->lock);
-    return -1;
-  }
-  np->sz = p->sz;
-
-  // copy saved user registers.
-  *(np->trapframe) = *(p->trapframe);
-
-  // Cause fork to return 0 in the child.
-  np->trapframe->a0 = 0;
-
-  // increment reference counts on open file descriptors.
-  for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);
-  np->cwd = idup(p->cwd);
-
-  safestrcpy(np->name, p->name, sizeof(p->name));
-
-  pid = np->pid;
-
-  release(&np->lock);
-
-  acquire(&wait_lock);
-  np->parent = p;
-  release(&wait_lock);
-
-  acquire(&np->lock);
-  np->state = RUNNABLE;
-  release(&np->lock);
-
-  return pid;
-}
-
-// Pass p's abandoned children to init.
-// Caller must hold wait_lock.
-void
-reparent(struct proc *p)
-{
-  struct proc *pp;
-
-  for(pp = proc; pp < &proc[NPROC]; pp++){
-    if(pp->parent == p){
-      pp->parent = initproc;
-      wakeup(initproc);
-    }
-  }
-}
-
-// Exit the current process.  Does not return.
-// An exited process remains in the zombie state
-// until its parent calls wait().
-void
-exit(int status)
-{
-  struct proc *p = myproc();
-
-  if(p == initproc)
-    panic("init exiting");
-
-  // Close all open files.
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);
-      p->ofile[fd] = 0;
-    }
-  }
-
-  begin_op();
-  iput(p->cwd);
-  end_op();
-  p->cwd = 0;
-
-  acquire(&wait_lock);
-
-  // Give any children to init.
-  reparent(p);
-
-  // Parent might be sleeping in wait().
-  wakeup(p->parent);
-  
-  acquire(&p->lock);
-
-  p->xstate = status;
-  p->state = ZOMBIE;
-
-  release(&wait_lock);
-
-  // Jump into the scheduler, never to return.
-  sched();
-  panic("zombie exit");
-}
-
-// Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
-int
-wait(uint64 addr)
-{
-  struct proc *pp;
-  int havekids, pid;
-  struct proc *p = myproc();
-
-  acquire(&wait_lock);
-
-  for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){
-        // make sure the child isn't still in exit() or swtch().
-        acquire(&pp->lock);
-
-        havekids = 1;
-        if(pp->state == ZOMBIE){
-          // Found one.
-          pid = pp->pid;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
-                                  sizeof(pp->xstate)) < 0) {
-            release(&pp->lock);
-            release(&wait_lock);
-            return -1;
-          }
-          freeproc(pp);
-          release(&pp->lock);
-          release(&wait_lock);
-          return pid;
-        }
-        release(&pp->lock);
-      }
-    }
-
-    // No point waiting if we don't have any children.
-    if(!havekids || killed(p)){
-      release(&wait_lock);
-      return -1;
-    }
-    
-    // Wait for a child to exit.
-    sleep(p, &wait_lock);  //DOC: wait-sleep
-  }
-}
-
-// Per-CPU process scheduler.
-// Each CPU calls scheduler() after setting itself up.
-// Scheduler never returns.  It loops, doing:
-//  - choose a process to run.
-//  - swtch to start running that process.
-//  - eventually that process transfers control
-//    via swtch back to the scheduler.
-void
-scheduler(void)
-{
-  struct proc *p;
-  struct cpu *c = mycpu();
-
-  c->proc = 0;
-  for(;;){
-    // The most recent process to run may have had interrupts
-    // turned off; enable them to avoid a deadlock if all
-    // processes are waiting. Then turn them back off
-    // to avoid a possible race between an interrupt
-    // and wfi.
-    intr_on();
-    intr_off();
-
-    int found = 0;
-    for(p = proc; p < &proc[NPROC]; p++) {
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        // Switch to chosen process.  It is the process's job
-        // to release its lock and then reacquire it
-        // before jumping back to us.
-        p->ticks = p->priority;
-        p->state = RUNNING;
-        c->proc = p;
-        swtch(&c->context, &p->context);
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-        found = 1;
-      }
-      release(&p->lock);
-    }
-    if(found == 0) {
-      // nothing to run; stop running on this core until an interrupt.
-      asm volatile("wfi");
-    }
-  }
-}
-
-// Switch to scheduler.  Must hold only p->lock
-// and have changed proc->state. Saves and restores
-// intena because intena is a property of this
-// kernel thread, not this CPU. It should
-// be proc->intena and proc->noff, but that would
-// break in the few places where a lock is held but
-// there's no process.
-void
-sched(void)
-{
-  int intena;
-  struct proc *p = myproc();
-
-  if(!holding(&p->lock))
-    panic("sched p->lock");
-  if(mycpu()->noff != 1)
-    panic("sched locks");
-  if(p->state == RUNNING)
-    panic("sched RUNNING");
-  if(intr_get())
-    panic("sched interruptible");
-
-  intena = mycpu()->intena;
-  swtch(&p->context, &mycpu()->context);
-  mycpu()->intena = intena;
-}
-
-// Give up the CPU for one scheduling round.
-void
-yield(void)
-{
-  struct proc *p = myproc();
-  acquire(&p->lock);
-  p->state = RUNNABLE;
-  sched();
-  release(&p->lock);
-}
-
-// A fork child's very first scheduling by scheduler()
-// will swtch to forkret.
-void
-forkret(void)
-{
-  static int first = 1;
-
-  // Still holding p->lock from scheduler.
-  release(&myproc()->lock);
-
-  if (first) {
-    // File system initialization must be run in the context of a
-    // regular process (e.g., because it calls sleep), and thus cannot
-    // be run from main().
-    fsinit(ROOTDEV);
-
-    first = 0;
-    // ensure other cores see first=0.
-    __sync_synchronize();
-  }
-
-  usertrapret();
-}
-
-// Sleep on wait channel chan, releasing condition lock lk.
-// Re-acquires lk when awakened.
-void
-sleep(void *chan, struct spinlock *lk)
-{
-  struct proc *p = myproc();
-  
-  // Must acquire p->lock in order to
-  // change p->state and then call sched.
-  // Once we hold p->lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
-  // so it's okay to release lk.
-
-  acquire(&p->lock);  //DOC: sleeplock1
-  release(lk);
-
-  // Go to sleep.
-  p->chan = chan;
-  p->state = SLEEPING;
-
-  sched();
-
-  // Tidy up.
-  p->chan = 0;
-
-  // Reacquire original lock.
-  release(&p->lock);
-  acquire(lk);
-}
-
-// Wake up all processes sleeping on wait channel chan.
-// Caller should hold the condition lock.
-void
-wakeup(void *chan)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
-      acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-    }
-  }
-}
-
-// Kill the process with the given pid.
-// The victim won't exit until it tries to return
-// to user space (see usertrap() in trap.c).
-int
-kill(int pid)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++){
-    acquire(&p->lock);
-    if(p->pid == pid){
-      p->killed = 1;
-      if(p->state == SLEEPING){
-        // Wake process from sleep().
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-      return 0;
-    }
-    release(&p->lock);
-  }
-  return -1;
-}
-
-void
-setkilled(struct proc *p)
-{
-  acquire(&p->lock);
-  p->killed = 1;
-  release(&p->lock);
-}
-
-int
-killed(struct proc *p)
-{
-  int k;
-  
-  acquire(&p->lock);
-  k = p->killed;
-  release(&p->lock);
-  return k;
-}
-
-// Copy to either a user address, or kernel address,
-// depending on usr_dst.
-// Returns 0 on success, -1 on error.
-int
-either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_dst){
-    return copyout(p->pagetable, dst, src, len);
-  } else {
-    memmove((char *)dst, src, len);
-    return 0;
-  }
-}
-
-// Copy from either a user address, or kernel address,
-// depending on usr_src.
-// Returns 0 on success, -1 on error.
-int
-either_copyin(void *dst, int user_src, uint64 src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_src){
-    return copyin(p->pagetable, dst, src, len);
-  } else {
-    memmove(dst, (char*)src, len);
-    return 0;
-  }
-}
-
-// Print a process listing to console.  For debugging.
-// Runs when user types ^P on console.
-// No lock to avoid wedging a stuck machine further.
-void
-procdump(void)
-{
-  static char *states[] = {
-  [UNUSED]    "unused",
-  [USED]      "used",
-  [SLEEPING]  "sleep ",
-  [RUNNABLE]  "runble",
-  [RUNNING]   "run   ",
-  [ZOMBIE]    "zombie"
-  };
-  struct proc *p;
-  char *state;
-
-  printf("\n");
-  for(p = proc; p < &proc[NPROC]; p++){
-    if(p->state == UNUSED)
-      continue;
-    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
-      state = states[p->state];
-    else
-      state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
-    printf("\n");
-  }
-}
\ No newline at end of file
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "pstat.h"
+
+struct cpu cpus[NCPU];
+
+struct proc proc[NPROC];
+
+struct proc *initproc;
+
+int nextpid = 1;
+struct spinlock pid_lock;
+
+#ifdef SCHED_MLFQ
+#define NLEVEL NMLFQ
+#else
+#define NLEVEL 1         // weighted round robin: a single FIFO
+#endif
+
+// Task 2.1: per-CPU run queues. A RUNNABLE process sits on the
+// FIFO queue of its home CPU, so each CPU round-robins over its
+// own processes and only contends on its own queue lock.
+// In MLFQ mode there is one FIFO per level and the highest
+// non-empty level runs first.
+// Lock order: p->lock before runq lock.
+static struct runq {
+  struct spinlock lock;
+  struct proc *head[NLEVEL];  // next process to run at each level
+  struct proc *tail[NLEVEL];
+  int nrunnable;              // length of all levels together
+  uint epoch;                 // MLFQ: boost period last applied
+  int idle;                   // tickless: owner is in wfi with its tick stopped
+} runqs[NCPU];
+
+#ifdef TICKLESS
+extern void timerset(void);
+#endif
+
+#ifdef SCHED_MLFQ
+// Priority boost. Every MLFQ_BOOST ticks of time (MLFQ_EPOCH())
+// all processes go back to the top level, so CPU-bound jobs parked
+// at the bottom can't starve. Both queues and processes apply it
+// lazily by comparing their epoch with the current boost period.
+
+// p->lock must be held.
+static void
+mlfq_refresh(struct proc *p)
+{
+  uint epoch = MLFQ_EPOCH();
+  if(p->epoch != epoch){
+    p->epoch = epoch;
+    p->level = 0;
+    p->used = 0;
+  }
+}
+
+// Splice every lower level onto level 0.
+// rq->lock must be held.
+static void
+mlfq_boost(struct runq *rq)
+{
+  uint epoch = MLFQ_EPOCH();
+  if(rq->epoch == epoch)
+    return;
+  rq->epoch = epoch;
+  for(int l = 1; l < NLEVEL; l++){
+    if(rq->head[l] == 0)
+      continue;
+    if(rq->tail[0])
+      rq->tail[0]->rq_next = rq->head[l];
+    else
+      rq->head[0] = rq->head[l];
+    rq->tail[0] = rq->tail[l];
+    rq->head[l] = rq->tail[l] = 0;
+  }
+}
+#endif
+
+// Append p to the tail of its level in rq.
+// rq->lock must be held.
+static void
+runq_append(struct runq *rq, struct proc *p)
+{
+  int l = p->level;
+
+  p->rq_next = 0;
+  if(rq->tail[l])
+    rq->tail[l]->rq_next = p;
+  else
+    rq->head[l] = p;
+  rq->tail[l] = p;
+  rq->nrunnable++;
+}
+
+// Queue p on rq.
+// In tickless mode this fails with -1 if rq belongs to another
+// CPU that has gone idle, since that CPU would not notice p.
+static int
+runq_push(struct runq *rq, struct proc *p)
+{
+  acquire(&rq->lock);
+#ifdef TICKLESS
+  if(rq->idle && rq != &runqs[cpuid()]){
+    release(&rq->lock);
+    return -1;
+  }
+#endif
+  runq_append(rq, p);
+  release(&rq->lock);
+  return 0;
+}
+
+// Take the process at the head of rq's highest non-empty level,
+// or return 0 if it is empty. If cpu is not -1, take the first
+// process that may run on cpu instead, for a steal. p->affinity
+// is read without p->lock; scheduler() checks it again.
+static struct proc*
+runq_pop(struct runq *rq, int cpu)
+{
+  struct proc *p = 0, *prev, **pp;
+
+  acquire(&rq->lock);
+#ifdef SCHED_MLFQ
+  mlfq_boost(rq);
+#endif
+  for(int l = 0; l < NLEVEL && p == 0; l++){
+    prev = 0;
+    for(pp = &rq->head[l]; (p = *pp) != 0; pp = &p->rq_next){
+      if(cpu < 0 || (p->affinity & (1 << cpu)))
+        break;
+      prev = p;
+    }
+    if(p){
+      *pp = p->rq_next;
+      if(rq->tail[l] == p)
+        rq->tail[l] = prev;
+      p->rq_next = 0;
+      rq->nrunnable--;
+    }
+  }
+  release(&rq->lock);
+  return p;
+}
+
+// Called by an idle CPU whose own queue is empty: take the
+// longest-waiting process of the busiest other queue.
+// nrunnable is read without locks; a stale read only means
+// an empty pop.
+static struct proc*
+runq_steal(int self)
+{
+  struct runq *victim = 0;
+  int most = 0;
+
+  for(int i = 0; i < NCPU; i++){
+    if(i != self && runqs[i].nrunnable > most){
+      most = runqs[i].nrunnable;
+      victim = &runqs[i];
+    }
+  }
+  if(victim == 0)
+    return 0;
+  return runq_pop(victim, self);
+}
+
+#ifdef TICKLESS
+// Mark rq idle if it is empty, so runq_push() stops queueing
+// work on it. Checking and marking under the same lock means a
+// push either lands before the check or sees the mark.
+// Returns 1 if rq was marked idle.
+static int
+runq_idle(struct runq *rq)
+{
+  int idle;
+
+  acquire(&rq->lock);
+  idle = rq->idle = (rq->nrunnable == 0);
+  release(&rq->lock);
+  return idle;
+}
+
+#define SSIP (1L << 1)          // supervisor software interrupt, in sie and sip
+
+// Queue p on the run queue of cpu even though cpu is idle, and wake
+// it out of wfi with a supervisor software interrupt through QEMU's
+// ACLINT SSWI device (make qemu passes aclint=on). Only the CPU that
+// clears the idle mark sends the IPI, so each wfi gets at most one.
+static void
+runq_kick(int cpu, struct proc *p)
+{
+  struct runq *rq = &runqs[cpu];
+  int idle;
+
+  acquire(&rq->lock);
+  idle = rq->idle;
+  rq->idle = 0;
+  runq_append(rq, p);
+  release(&rq->lock);
+  if(idle)
+    *(volatile uint32*)ACLINT_SETSSIP(cpu) = 1;
+}
+#endif
+
+// Mark p RUNNABLE and queue it on its home CPU.
+// p->lock must be held.
+static void
+setrunnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  p->readytime = r_time();
+  if(p->edf)
+    return; // EDF processes aren't queued, see edf_pick()
+#ifdef SCHED_MLFQ
+  mlfq_refresh(p);
+#endif
+#ifdef TICKLESS
+  // if p would wait on its busy home CPU behind another process,
+  // wake an idle CPU p may use instead, so p runs now rather than
+  // a quantum later. Only if none is idle does p queue on home,
+  // and if home itself is asleep without a tick, wake it.
+  // idle, nrunnable and cpus[].proc are read without locks; a
+  // stale read only means p is queued on a busy CPU, which picks
+  // it up at the end of its quantum.
+  int home = p->home;
+  struct proc *running = cpus[home].proc;
+  if(!runqs[home].idle &&
+     (runqs[home].nrunnable > 0 || (running != 0 && running != p))){
+    for(int i = 0; i < NCPU; i++){
+      if(i != home && (p->affinity & (1 << i)) && runqs[i].idle){
+        p->home = i;
+        runq_kick(i, p);
+        return;
+      }
+    }
+  }
+  if(runq_push(&runqs[home], p) < 0)
+    runq_kick(home, p);
+#else
+  runq_push(&runqs[p->home], p);
+#endif
+}
+
+// Task 2.1: CPU affinity. p->affinity is a mask of the CPUs p may
+// run on, all of them unless setaffinity() pinned it. p->home is
+// always kept inside the mask, so a process is only ever queued on
+// a CPU it may use, and only stealing has to check.
+#define ALLCPUS ((1 << NCPU) - 1)
+
+// harts that have entered scheduler(). make qemu starts CPUS of
+// the NCPU harts, and setaffinity() only accepts these.
+static int startedcpus;
+
+// Move p->home to the lowest CPU in p->affinity if it isn't in it.
+// p->lock must be held.
+static void
+affine(struct proc *p)
+{
+  if(p->affinity & (1 << p->home))
+    return;
+  for(int i = 0; i < NCPU; i++){
+    if(p->affinity & (1 << i)){
+      p->home = i;
+      return;
+    }
+  }
+}
+
+// Task 2.1: earliest-deadline-first class. A process that called
+// sched_setdeadline(runtime, period) gets runtime ticks of CPU in
+// every period of period ticks. Admission is per CPU: the process
+// is placed on one CPU whose EDF utilisation stays at most 1, and
+// only that CPU runs it. EDF processes are not on the run queues;
+// each CPU first runs its RUNNABLE EDF process with the earliest
+// deadline and budget left, and the WRR/MLFQ run queue
+// only gets the leftover time. A process that uses up its budget
+// is throttled until its next period starts.
+// Lock order: p->lock before edfq lock.
+#define EDF_UMAX 1000    // utilisation limit per CPU, per mille
+
+static struct edfq {
+  struct spinlock lock;
+  struct proc *head;     // EDF processes admitted on this CPU
+  int util;              // sum of their p->edf
+} edfqs[NCPU];
+
+// Return the RUNNABLE EDF process of CPU id with budget left and
+// the earliest deadline, or 0. Processes whose deadline has passed
+// start a new period first. p->state is read without p->lock, so
+// the caller checks it again.
+static struct proc*
+edf_pick(int id)
+{
+  struct edfq *eq = &edfqs[id];
+  struct proc *p, *best = 0;
+  uint64 now = r_time();
+
+  if(eq->head == 0)
+    return 0;
+  acquire(&eq->lock);
+  for(p = eq->head; p; p = p->edfnext){
+    if(now >= p->deadline){
+      p->deadline += ((now - p->deadline) / p->edfperiod + 1) * p->edfperiod;
+      p->budget = p->edfrun;
+    }
+    if(p->state == RUNNABLE && p->budget > 0 &&
+       (best == 0 || p->deadline < best->deadline))
+      best = p;
+  }
+  release(&eq->lock);
+  return best;
+}
+
+// Take cycles p just ran out of its budget.
+// p->lock must be held.
+static void
+edf_charge(struct proc *p, uint64 used)
+{
+  struct edfq *eq = &edfqs[p->edfcpu];
+
+  acquire(&eq->lock);
+  p->budget = used < p->budget ? p->budget - used : 0;
+  release(&eq->lock);
+}
+
+// Move p back to the normal class.
+// p->lock must be held.
+static void
+edf_leave(struct proc *p)
+{
+  struct edfq *eq = &edfqs[p->edfcpu];
+  struct proc **pp;
+
+  if(p->edf == 0)
+    return;
+  acquire(&eq->lock);
+  for(pp = &eq->head; *pp != p; pp = &(*pp)->edfnext)
+    ;
+  *pp = p->edfnext;
+  p->edfnext = 0;
+  eq->util -= p->edf;
+  p->edf = 0;
+  release(&eq->lock);
+}
+
+// Should the running process p give up its CPU for EDF work?
+// Yes if p is EDF and has overrun its budget, or if an EDF process
+// with an earlier deadline is waiting on p's CPU.
+int
+edf_preempt(struct proc *p)
+{
+  struct proc *q;
+
+  if(p->edf && r_time() - p->runstart >= p->budget)
+    return 1;
+  q = edf_pick(p->lastcpu);
+  return q != 0 && q != p && (p->edf == 0 || q->deadline < p->deadline);
+}
+
+// Does CPU id have EDF processes to keep an eye on?
+int
+edf_homed(int id)
+{
+  return edfqs[id].head != 0;
+}
+
+// Task 2.1: add one wakeup-to-run latency of the given time
+// CSR cycles (10 per microsecond) to p's histogram.
+static void
+latency(struct proc *p, uint64 cycles)
+{
+  uint64 us = cycles / (PSTAT_TICK / 100000);
+  int b = 0;
+
+  while(b < PSTAT_NLAT - 1 && us >= 2){
+    us >>= 1;
+    b++;
+  }
+  p->wakelat[b]++;
+}
+
+extern void forkret(void);
+static void freeproc(struct proc *p);
+
+extern char trampoline[]; // trampoline.S
+
+// helps ensure that wakeups of wait()ing
+// parents are not lost. helps obey the
+// memory model when using p->parent.
+// must be acquired before any p->lock.
+struct spinlock wait_lock;
+
+// Allocate a page for each process's kernel stack.
+// Map it high in memory, followed by an invalid
+// guard page.
+void
+proc_mapstacks(pagetable_t kpgtbl)
+{
+  struct proc *p;
+  
+  for(p = proc; p < &proc[NPROC]; p++) {
+    char *pa = kalloc();
+    if(pa == 0)
+      panic("kalloc");
+    uint64 va = KSTACK((int) (p - proc));
+    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
+  }
+}
+
+// initialize the proc table.
+void
+procinit(void)
+{
+  struct proc *p;
+  
+  initlock(&pid_lock, "nextpid");
+  initlock(&wait_lock, "wait_lock");
+  for(int i = 0; i < NCPU; i++){
+    initlock(&runqs[i].lock, "runq");
+    initlock(&edfqs[i].lock, "edfq");
+  }
+  for(p = proc; p < &proc[NPROC]; p++) {
+      initlock(&p->lock, "proc");
+      p->state = UNUSED;
+      p->kstack = KSTACK((int) (p - proc));
+  }
+}
+
+// Must be called with interrupts disabled,
+// to prevent race with process being moved
+// to a different CPU.
+int
+cpuid()
+{
+  int id = r_tp();
+  return id;
+}
+
+// Return this CPU's cpu struct.
+// Interrupts must be disabled.
+struct cpu*
+mycpu(void)
+{
+  int id = cpuid();
+  struct cpu *c = &cpus[id];
+  return c;
+}
+
+// Return the current struct proc *, or zero if none.
+struct proc*
+myproc(void)
+{
+  push_off();
+  struct cpu *c = mycpu();
+  struct proc *p = c->proc;
+  pop_off();
+  return p;
+}
+
+int
+allocpid()
+{
+  int pid;
+  
+  acquire(&pid_lock);
+  pid = nextpid;
+  nextpid = nextpid + 1;
+  release(&pid_lock);
+
+  return pid;
+}
+
+// Look in the process table for an UNUSED proc.
+// If found, initialize state required to run in the kernel,
+// and return with p->lock held.
+// If there are no free procs, or a memory allocation fails, return 0.
+static struct proc*
+allocproc(void)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    acquire(&p->lock);
+    if(p->state == UNUSED) {
+      goto found;
+    } else {
+      release(&p->lock);
+    }
+  }
+  return 0;
+
+found:
+  p->pid = allocpid();
+  p->state = USED;
+
+  // Task 2.1
+  p->priority = DEFAULT_PRIORITY;
+  p->used = 0;
+  p->home = cpuid(); // interrupts are off while p->lock is held
+  p->level = 0;      // MLFQ: new processes start at the top
+  p->epoch = MLFQ_EPOCH();
+  p->lastcpu = p->home;
+  p->affinity = ALLCPUS;
+  p->nsched = p->nvcsw = p->nivcsw = 0;
+  p->cputime = p->waittime = p->childtime = 0;
+  p->woken = 0;
+  memset(p->wakelat, 0, sizeof(p->wakelat));
+
+  // Allocate a trapframe page.
+  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // An empty user page table.
+  p->pagetable = proc_pagetable(p);
+  if(p->pagetable == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // Set up new context to start executing at forkret,
+  // which returns to user space.
+  memset(&p->context, 0, sizeof(p->context));
+  p->context.ra = (uint64)forkret;
+  p->context.sp = p->kstack + PGSIZE;
+
+  return p;
+}
+
+// free a proc structure and the data hanging from it,
+// including user pages.
+// p->lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  if(p->trapframe)
+    kfree((void*)p->trapframe);
+  p->trapframe = 0;
+  if(p->pagetable)
+    proc_freepagetable(p->pagetable, p->sz);
+  p->pagetable = 0;
+  p->sz = 0;
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->chan = 0;
+  p->killed = 0;
+  p->xstate = 0;
+  edf_leave(p); // no-op unless exit() was skipped
+  p->state = UNUSED;
+}
+
+// Create a user page table for a given process, with no user memory,
+// but with trampoline and trapframe pages.
+pagetable_t
+proc_pagetable(struct proc *p)
+{
+  pagetable_t pagetable;
+
+  // An empty page table.
+  pagetable = uvmcreate();
+  if(pagetable == 0)
+    return 0;
+
+  // map the trampoline code (for system call return)
+  // at the highest user virtual address.
+  // only the supervisor uses it, on the way
+  // to/from user space, so not PTE_U.
+  if(mappages(pagetable, TRAMPOLINE, PGSIZE,
+              (uint64)trampoline, PTE_R | PTE_X) < 0){
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  // map the trapframe page just below the trampoline page, for
+  // trampoline.S.
+  if(mappages(pagetable, TRAPFRAME, PGSIZE,
+              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  return pagetable;
+}
+
+// Free a process's page table, and free the
+// physical memory it refers to.
+void
+proc_freepagetable(pagetable_t pagetable, uint64 sz)
+{
+  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+  uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  uvmfree(pagetable, sz);
+}
+
+// a user program that calls exec("/init")
+// assembled from ../user/initcode.S
+// od -t xC ../user/initcode
+uchar initcode[] = {
+  0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0x45, 0x02,
+  0x97, 0x05, 0x00, 0x00, 0x93, 0x85, 0x35, 0x02,
+  0x93, 0x08, 0x70, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0x93, 0x08, 0x20, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0xef, 0xf0, 0x9f, 0xff, 0x2f, 0x69, 0x6e, 0x69,
+  0x74, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+
+// Set up first user process.
+void
+userinit(void)
+{
+  struct proc *p;
+
+  p = allocproc();
+  initproc = p;
+  
+  // allocate one user page and copy initcode's instructions
+  // and data into it.
+  uvmfirst(p->pagetable, initcode, sizeof(initcode));
+  p->sz = PGSIZE;
+
+  // prepare for the very first "return" from kernel to user.
+  p->trapframe->epc = 0;      // user program counter
+  p->trapframe->sp = PGSIZE;  // user stack pointer
+
+  safestrcpy(p->name, "initcode", sizeof(p->name));
+  p->cwd = namei("/");
+
+  setrunnable(p);
+
+  release(&p->lock);
+}
+
+// Grow or shrink user memory by n bytes.
+// Return 0 on success, -1 on failure.
+int
+growproc(int n)
+{
+  uint64 sz;
+  struct proc *p = myproc();
+
+  sz = p->sz;
+  if(n > 0){
+    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
+      return -1;
+    }
+  } else if(n < 0){
+    sz = uvmdealloc(p->pagetable, sz, sz + n);
+  }
+  p->sz = sz;
+  return 0;
+}
+
+// Create a new process, copying the parent.
+// Sets up child kernel stack to return as if from fork() system call.
+int
+fork(void)
+{
+  int i, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  // Task 2.1
+  np->priority = p->priority;
+  np->used = 0;
+
+  // Copy user memory from parent to child.
+  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  np->sz = p->sz;
+
+  // copy saved user registers.
+  *(np->trapframe) = *(p->trapframe);
+
+  // Cause fork to return 0 in the child.
+  np->trapframe->a0 = 0;
+
+  // increment reference counts on open file descriptors.
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  // Task 2.1: the child inherits the parent's CPU affinity.
+  np->affinity = p->affinity;
+  affine(np);
+
+  pid = np->pid;
+
+  release(&np->lock);
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  setrunnable(np);
+  release(&np->lock);
+
+  return pid;
+}
+
+// Pass p's abandoned children to init.
+// Caller must hold wait_lock.
+void
+reparent(struct proc *p)
+{
+  struct proc *pp;
+
+  for(pp = proc; pp < &proc[NPROC]; pp++){
+    if(pp->parent == p){
+      pp->parent = initproc;
+      wakeup(initproc);
+    }
+  }
+}
+
+// Exit the current process.  Does not return.
+// An exited process remains in the zombie state
+// until its parent calls wait().
+void
+exit(int status)
+{
+  struct proc *p = myproc();
+
+  if(p == initproc)
+    panic("init exiting");
+
+  // Close all open files.
+  for(int fd = 0; fd < NOFILE; fd++){
+    if(p->ofile[fd]){
+      struct file *f = p->ofile[fd];
+      fileclose(f);
+      p->ofile[fd] = 0;
+    }
+  }
+
+  begin_op();
+  iput(p->cwd);
+  end_op();
+  p->cwd = 0;
+
+  acquire(&wait_lock);
+
+  // Give any children to init.
+  reparent(p);
+
+  // Parent might be sleeping in wait().
+  wakeup(p->parent);
+  
+  acquire(&p->lock);
+
+  p->xstate = status;
+  p->state = ZOMBIE;
+  // Task 2.1: a zombie won't run again, so its EDF reservation is
+  // free for admission now rather than once the parent waits.
+  edf_leave(p);
+
+  release(&wait_lock);
+
+  // Jump into the scheduler, never to return.
+  sched();
+  panic("zombie exit");
+}
+
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+int
+wait(uint64 addr)
+{
+  struct proc *pp;
+  int havekids, pid;
+  struct proc *p = myproc();
+
+  acquire(&wait_lock);
+
+  for(;;){
+    // Scan through table looking for exited children.
+    havekids = 0;
+    for(pp = proc; pp < &proc[NPROC]; pp++){
+      if(pp->parent == p){
+        // make sure the child isn't still in exit() or swtch().
+        acquire(&pp->lock);
+
+        havekids = 1;
+        if(pp->state == ZOMBIE){
+          // Found one.
+          pid = pp->pid;
+          p->childtime += pp->cputime + pp->childtime;
+          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
+                                  sizeof(pp->xstate)) < 0) {
+            release(&pp->lock);
+            release(&wait_lock);
+            return -1;
+          }
+          freeproc(pp);
+          release(&pp->lock);
+          release(&wait_lock);
+          return pid;
+        }
+        release(&pp->lock);
+      }
+    }
+
+    // No point waiting if we don't have any children.
+    if(!havekids || killed(p)){
+      release(&wait_lock);
+      return -1;
+    }
+    
+    // Wait for a child to exit.
+    sleep(p, &wait_lock);  //DOC: wait-sleep
+  }
+}
+
+// Task 2.1: charge ran cycles to p's quantum as it comes back from
+// a run. The quantum only starts over once it has been used up, so
+// giving up the CPU early doesn't buy a fresh one. Under MLFQ a
+// used-up quantum moves p down a level, and blocking before then
+// moves it up one.
+// p->lock must be held.
+static void
+charge(struct proc *p, uint64 ran)
+{
+  p->used += ran;
+  if(SPENT(p, p->used)){
+    p->used = 0;
+#ifdef SCHED_MLFQ
+    if(p->level < NMLFQ - 1)
+      p->level++;
+#endif
+    return;
+  }
+#ifdef SCHED_MLFQ
+  if(p->state == SLEEPING && p->level > 0){
+    p->level--;
+    p->used = 0;
+  }
+#endif
+}
+
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+// Scheduler never returns.  It loops, doing:
+//  - choose a process to run.
+//  - swtch to start running that process.
+//  - eventually that process transfers control
+//    via swtch back to the scheduler.
+void
+scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+  int id = cpuid();
+
+  c->proc = 0;
+  __sync_fetch_and_or(&startedcpus, 1 << id); // Task 2.1
+  for(;;){
+    // The most recent process to run may have had interrupts
+    // turned off; enable them to avoid a deadlock if all
+    // processes are waiting. Then turn them back off
+    // to avoid a possible race between an interrupt
+    // and wfi.
+    intr_on();
+    intr_off();
+
+    // Task 2.1: EDF processes admitted here come first.
+    p = edf_pick(id);
+    if(p == 0)
+      p = runq_pop(&runqs[id], -1);
+    if(p == 0)
+      p = runq_steal(id);
+    if(p == 0){
+#ifdef TICKLESS
+      // stop the tick too: only a sleeper deadline or a
+      // device interrupt wakes this core.
+      if(runq_idle(&runqs[id])){
+        timerset();
+        // wfi also returns for a pending SSIP from runq_kick()
+        // while interrupts are off. A kick that lands after
+        // SSIP is cleared only ends the next wfi early.
+        w_sie(r_sie() | SSIP);
+        asm volatile("wfi");
+        w_sie(r_sie() & ~SSIP);
+        w_sip(r_sip() & ~SSIP);
+        acquire(&runqs[id].lock);
+        runqs[id].idle = 0;
+        release(&runqs[id].lock);
+      }
+#else
+      // nothing to run; stop running on this core until an interrupt.
+      asm volatile("wfi");
+#endif
+      continue;
+    }
+
+    // p left its queue in runq_pop(), so no other CPU
+    // can pick it and it is still RUNNABLE here.
+    acquire(&p->lock);
+    if(p->state == RUNNABLE && !p->edf && !(p->affinity & (1 << id))){
+      // Task 2.1: setaffinity() pinned p away from this CPU
+      // while it was queued here: queue it on its new home.
+      affine(p);
+      setrunnable(p);
+    } else if(p->state == RUNNABLE) {
+      // Switch to chosen process.  It is the process's job
+      // to release its lock and then reacquire it
+      // before jumping back to us.
+      p->home = id; // a stolen process stays on its new CPU
+#ifdef SCHED_MLFQ
+      mlfq_refresh(p);
+#endif
+      p->runstart = r_time();
+      p->waittime += p->runstart - p->readytime;
+      if(p->woken){
+        p->woken = 0;
+        latency(p, p->runstart - p->readytime);
+      }
+      p->nsched++;
+      p->lastcpu = id;
+      p->state = RUNNING;
+      c->proc = p;
+#ifdef TICKLESS
+      // one timer interrupt at the end of p's quantum.
+      timerset();
+#endif
+      swtch(&c->context, &p->context);
+
+      // Process is done running for now.
+      // It should have changed its p->state before coming back.
+      c->proc = 0;
+      uint64 ran = r_time() - p->runstart;
+      p->cputime += ran;
+      if(p->edf)
+        edf_charge(p, ran);
+      else
+        charge(p, ran);
+      // Task 2.1: yield() leaves queueing p to us, so p joins
+      // the queue of the level charge() just gave it.
+      if(p->state == RUNNABLE)
+        setrunnable(p);
+    }
+    release(&p->lock);
+  }
+}
+
+// Switch to scheduler.  Must hold only p->lock
+// and have changed proc->state. Saves and restores
+// intena because intena is a property of this
+// kernel thread, not this CPU. It should
+// be proc->intena and proc->noff, but that would
+// break in the few places where a lock is held but
+// there's no process.
+void
+sched(void)
+{
+  int intena;
+  struct proc *p = myproc();
+
+  if(!holding(&p->lock))
+    panic("sched p->lock");
+  if(mycpu()->noff != 1)
+    panic("sched locks");
+  if(p->state == RUNNING)
+    panic("sched RUNNING");
+  if(intr_get())
+    panic("sched interruptible");
+
+  intena = mycpu()->intena;
+  swtch(&p->context, &mycpu()->context);
+  mycpu()->intena = intena;
+}
+
+// Give up the CPU for one scheduling round.
+// Task 2.1: scheduler() queues p once it has charged the run.
+void
+yield(void)
+{
+  struct proc *p = myproc();
+  acquire(&p->lock);
+  p->nivcsw++;
+  p->state = RUNNABLE;
+  sched();
+  release(&p->lock);
+}
+
+// A fork child's very first scheduling by scheduler()
+// will swtch to forkret.
+void
+forkret(void)
+{
+  static int first = 1;
+
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
+
+  if (first) {
+    // File system initialization must be run in the context of a
+    // regular process (e.g., because it calls sleep), and thus cannot
+    // be run from main().
+    fsinit(ROOTDEV);
+
+    first = 0;
+    // ensure other cores see first=0.
+    __sync_synchronize();
+  }
+
+  usertrapret();
+}
+
+// Sleep on wait channel chan, releasing condition lock lk.
+// Re-acquires lk when awakened.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  struct proc *p = myproc();
+  
+  // Must acquire p->lock in order to
+  // change p->state and then call sched.
+  // Once we hold p->lock, we can be
+  // guaranteed that we won't miss any wakeup
+  // (wakeup locks p->lock),
+  // so it's okay to release lk.
+
+  acquire(&p->lock);  //DOC: sleeplock1
+  release(lk);
+
+  // Go to sleep.
+  p->chan = chan;
+  p->state = SLEEPING;
+  p->nvcsw++;
+
+  sched();
+
+  // Tidy up.
+  p->chan = 0;
+
+  // Reacquire original lock.
+  release(&p->lock);
+  acquire(lk);
+}
+
+// Wake up all processes sleeping on wait channel chan.
+// Caller should hold the condition lock.
+void
+wakeup(void *chan)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    if(p != myproc()){
+      acquire(&p->lock);
+      if(p->state == SLEEPING && p->chan == chan) {
+        p->woken = 1;
+        setrunnable(p);
+      }
+      release(&p->lock);
+    }
+  }
+}
+
+// Kill the process with the given pid.
+// The victim won't exit until it tries to return
+// to user space (see usertrap() in trap.c).
+int
+kill(int pid)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid){
+      p->killed = 1;
+      if(p->state == SLEEPING){
+        // Wake process from sleep().
+        setrunnable(p);
+      }
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+void
+setkilled(struct proc *p)
+{
+  acquire(&p->lock);
+  p->killed = 1;
+  release(&p->lock);
+}
+
+int
+killed(struct proc *p)
+{
+  int k;
+  
+  acquire(&p->lock);
+  k = p->killed;
+  release(&p->lock);
+  return k;
+}
+
+// Copy to either a user address, or kernel address,
+// depending on usr_dst.
+// Returns 0 on success, -1 on error.
+int
+either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_dst){
+    return copyout(p->pagetable, dst, src, len);
+  } else {
+    memmove((char *)dst, src, len);
+    return 0;
+  }
+}
+
+// Copy from either a user address, or kernel address,
+// depending on usr_src.
+// Returns 0 on success, -1 on error.
+int
+either_copyin(void *dst, int user_src, uint64 src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_src){
+    return copyin(p->pagetable, dst, src, len);
+  } else {
+    memmove(dst, (char*)src, len);
+    return 0;
+  }
+}
+
+// Print a process listing to console.  For debugging.
+// Runs when user types ^P on console.
+// No lock to avoid wedging a stuck machine further.
+void
+procdump(void)
+{
+  static char *states[] = {
+  [UNUSED]    "unused",
+  [USED]      "used",
+  [SLEEPING]  "sleep ",
+  [RUNNABLE]  "runble",
+  [RUNNING]   "run   ",
+  [ZOMBIE]    "zombie"
+  };
+  struct proc *p;
+  char *state;
+
+  printf("\n");
+  for(p = proc; p < &proc[NPROC]; p++){
+    if(p->state == UNUSED)
+      continue;
+    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
+      state = states[p->state];
+    else
+      state = "???";
+    printf("%d %s %s", p->pid, state, p->name);
+    printf("\n");
+  }
+}
+
+// Task 2.1: copy p's scheduling statistics into st,
+// including the part of the current run or wait so far.
+// p->lock must be held.
+static void
+fillpstat(struct proc *p, struct pstat *st)
+{
+  st->pid = p->pid;
+  st->state = p->state;
+  safestrcpy(st->name, p->name, sizeof(st->name));
+  st->priority = p->priority;
+  st->lastcpu = p->lastcpu;
+  st->nsched = p->nsched;
+  st->nvcsw = p->nvcsw;
+  st->nivcsw = p->nivcsw;
+  st->cputime = p->cputime;
+  st->waittime = p->waittime;
+  memmove(st->wakelat, p->wakelat, sizeof(st->wakelat));
+  if(p->state == RUNNING)
+    st->cputime += r_time() - p->runstart;
+  else if(p->state == RUNNABLE)
+    st->waittime += r_time() - p->readytime;
+}
+
+// Copy the statistics of process pid to user address addr.
+// Returns 0, or -1 if there is no such process.
+int
+getprocstats(int pid, uint64 addr)
+{
+  struct proc *p;
+  struct pstat st;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      fillpstat(p, &st);
+      release(&p->lock);
+      return copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st));
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Copy the statistics of up to n processes to the user array
+// at addr. Returns how many were copied, or -1.
+int
+getallprocstats(uint64 addr, int n)
+{
+  struct proc *p;
+  struct pstat st;
+  int i = 0;
+
+  for(p = proc; p < &proc[NPROC] && i < n; p++){
+    acquire(&p->lock);
+    if(p->state == UNUSED){
+      release(&p->lock);
+      continue;
+    }
+    fillpstat(p, &st);
+    release(&p->lock);
+    if(copyout(myproc()->pagetable, addr + i * sizeof(st), (char *)&st, sizeof(st)) < 0)
+      return -1;
+    i++;
+  }
+  return i;
+}
+
+// Task 2.1: restrict process pid (0 for the caller) to the CPUs in
+// mask. CPUs that never started are dropped from mask. Returns 0,
+// or -1 if there is no such process or mask has no started CPU
+// in it.
+int
+setaffinity(int pid, int mask)
+{
+  struct proc *p;
+  struct proc *me = myproc();
+
+  mask &= startedcpus;
+  if(mask == 0)
+    return -1;
+  if(pid == 0)
+    pid = me->pid;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      p->affinity = mask;
+      // a queued process moves when its CPU next picks it.
+      if(p->state != RUNNABLE)
+        affine(p);
+      int away = !(mask & (1 << p->lastcpu));
+      release(&p->lock);
+      // leave this CPU now if it is no longer allowed.
+      if(p == me && away)
+        yield();
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Return the affinity mask of process pid (0 for the caller),
+// or -1 if there is no such process.
+int
+getaffinity(int pid)
+{
+  struct proc *p;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      int mask = p->affinity;
+      release(&p->lock);
+      return mask;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Task 2.1: put the caller in the EDF class with runtime ticks of CPU
+// every period ticks, or back in the normal class if runtime is 0.
+// Returns 0, or -1 if the arguments are bad or no CPU the caller may
+// run on has room for runtime/period more utilisation. An EDF
+// process stays on the CPU it was admitted on; setaffinity() only
+// takes effect once it leaves the class. Children are not EDF.
+int
+sched_setdeadline(int runtime, int period)
+{
+  struct proc *p = myproc();
+  int u, cpu = -1;
+
+  if(runtime < 0 || period <= 0 || runtime > period)
+    return -1;
+  u = ((uint64)runtime * EDF_UMAX + period - 1) / period;
+
+  acquire(&p->lock);
+  if(u > 0){
+    // reserve u on the first CPU with room, starting with this one,
+    // counting what p already holds there.
+    for(int k = 0; k < NCPU && cpu < 0; k++){
+      int i = (p->lastcpu + k) % NCPU;
+      struct edfq *eq = &edfqs[i];
+      if(!(p->affinity & (1 << i)))
+        continue;
+      acquire(&eq->lock);
+      int mine = (p->edf && p->edfcpu == i) ? p->edf : 0;
+      if(eq->util - mine + u <= EDF_UMAX){
+        eq->util += u;
+        cpu = i;
+      }
+      release(&eq->lock);
+    }
+    if(cpu < 0){
+      release(&p->lock);
+      return -1;
+    }
+  }
+
+  edf_leave(p);
+  if(u > 0){
+    struct edfq *eq = &edfqs[cpu];
+    acquire(&eq->lock);
+    p->edf = u;
+    p->edfcpu = cpu;
+    p->home = cpu;
+    p->edfrun = (uint64)runtime * TICK_CYCLES;
+    p->edfperiod = (uint64)period * TICK_CYCLES;
+    p->deadline = r_time() + p->edfperiod;
+    p->budget = p->edfrun;
+    p->edfnext = eq->head;
+    eq->head = p;
+    release(&eq->lock);
+  }
+  release(&p->lock);
+
+  // continue in the new class, on its CPU.
+  yield();
+  return 0;
+}
+
+// Task 2.1: copy the caller's CPU usage (who is RUSAGE_SELF) or
+// that of the children it has waited for (RUSAGE_CHILDREN) to
+// user address addr. Returns 0, or -1.
+int
+getrusage(int who, uint64 addr)
+{
+  struct proc *p = myproc();
+  struct rusage ru;
+
+  memset(&ru, 0, sizeof(ru));
+  acquire(&p->lock);
+  if(who == RUSAGE_SELF){
+    ru.cputime = CYCLES_NS(p->cputime + (r_time() - p->runstart));
+    ru.waittime = CYCLES_NS(p->waittime);
+    ru.nvcsw = p->nvcsw;
+    ru.nivcsw = p->nivcsw;
+  } else if(who == RUSAGE_CHILDREN){
+    ru.cputime = CYCLES_NS(p->childtime);
+  } else {
+    release(&p->lock);
+    return -1;
+  }
+  release(&p->lock);
+  return copyout(p->pagetable, addr, (char *)&ru, sizeof(ru));
+}
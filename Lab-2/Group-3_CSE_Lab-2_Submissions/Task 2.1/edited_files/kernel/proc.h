@@ -1,111 +1,181 @@
-// Saved registers for kernel context switches.
-struct context {
-  uint64 ra;
-  uint64 sp;
-
-  // callee-saved
-  uint64 s0;
-  uint64 s1;
-  uint64 s2;
-  uint64 s3;
-  uint64 s4;
-  uint64 s5;
-  uint64 s6;
-  uint64 s7;
-  uint64 s8;
-  uint64 s9;
-  uint64 s10;
-  uint64 s11;
-};
-
-// Per-CPU state.
-struct cpu {
-  struct proc *proc;          // The process running on this cpu, or null.
-  struct context context;     // swtch() here to enter scheduler().
-  int noff;                   // Depth of push_off() nesting.
-  int intena;                 // Were interrupts enabled before push_off()?
-};
-
-extern struct cpu cpus[NCPU];
-
-// per-process data for the trap handling code in trampoline.S.
-// sits in a page by itself just under the trampoline page in the
-// user page table. not specially mapped in the kernel page table.
-// uservec in trampoline.S saves user registers in the trapframe,
-// then initializes registers from the trapframe's
-// kernel_sp, kernel_hartid, kernel_satp, and jumps to kernel_trap.
-// usertrapret() and userret in trampoline.S set up
-// the trapframe's kernel_*, restore user registers from the
-// trapframe, switch to the user page table, and enter user space.
-// the trapframe includes callee-saved user registers like s0-s11 because the
-// return-to-user path via usertrapret() doesn't return through
-// the entire kernel call stack.
-struct trapframe {
-  /*   0 */ uint64 kernel_satp;   // kernel page table
-  /*   8 */ uint64 kernel_sp;     // top of process's kernel stack
-  /*  16 */ uint64 kernel_trap;   // usertrap()
-  /*  24 */ uint64 epc;           // saved user program counter
-  /*  32 */ uint64 kernel_hartid; // saved kernel tp
-  /*  40 */ uint64 ra;
-  /*  48 */ uint64 sp;
-  /*  56 */ uint64 gp;
-  /*  64 */ uint64 tp;
-  /*  72 */ uint64 t0;
-  /*  80 */ uint64 t1;
-  /*  88 */ uint64 t2;
-  /*  96 */ uint64 s0;
-  /* 104 */ uint64 s1;
-  /* 112 */ uint64 a0;
-  /* 120 */ uint64 a1;
-  /* 128 */ uint64 a2;
-  /* 136 */ uint64 a3;
-  /* 144 */ uint64 a4;
-  /* 152 */ uint64 a5;
-  /* 160 */ uint64 a6;
-  /* 168 */ uint64 a7;
-  /* 176 */ uint64 s2;
-  /* 184 */ uint64 s3;
-  /* 192 */ uint64 s4;
-  /* 200 */ uint64 s5;
-  /* 208 */ uint64 s6;
-  /* 216 */ uint64 s7;
-  /* 224 */ uint64 s8;
-  /* 232 */ uint64 s9;
-  /* 240 */ uint64 s10;
-  /* 248 */ uint64 s11;
-  /* 256 */ uint64 t3;
-  /* 264 */ uint64 t4;
-  /* 272 */ uint64 t5;
-  /* 280 */ uint64 t6;
-};
-
-enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
-
-// Per-process state
-struct proc {
-  struct spinlock lock;
-
-  // p->lock must be held when using these:
-  enum procstate state;        // Process state
-  void *chan;                  // If non-zero, sleeping on chan
-  int killed;                  // If non-zero, have been killed
-  int xstate;                  // Exit status to be returned to parent's wait
-  int pid;                     // Process ID
-
-  // wait_lock must be held when using this:
-  struct proc *parent;         // Parent process
-
-  // these are private to the process, so p->lock need not be held.
-  uint64 kstack;               // Virtual address of kernel stack
-  uint64 sz;                   // Size of process memory (bytes)
-  pagetable_t pagetable;       // User page table
-  struct trapframe *trapframe; // data page for trampoline.S
-  struct context context;      // swtch() here to run process
-  struct file *ofile[NOFILE];  // Open files
-  struct inode *cwd;           // Current directory
-  char name[16];               // Process name (debugging)
-
-  // for Task 2.1
-  int priority;               // Process priority
-  int ticks;                 // Ticks used by the process
-};
+#include "pstat.h" // Task 2.1: PSTAT_NLAT
+
+// Saved registers for kernel context switches.
+struct context {
+  uint64 ra;
+  uint64 sp;
+
+  // callee-saved
+  uint64 s0;
+  uint64 s1;
+  uint64 s2;
+  uint64 s3;
+  uint64 s4;
+  uint64 s5;
+  uint64 s6;
+  uint64 s7;
+  uint64 s8;
+  uint64 s9;
+  uint64 s10;
+  uint64 s11;
+};
+
+// Per-CPU state.
+struct cpu {
+  struct proc *proc;          // The process running on this cpu, or null.
+  struct context context;     // swtch() here to enter scheduler().
+  int noff;                   // Depth of push_off() nesting.
+  int intena;                 // Were interrupts enabled before push_off()?
+};
+
+extern struct cpu cpus[NCPU];
+
+// per-process data for the trap handling code in trampoline.S.
+// sits in a page by itself just under the trampoline page in the
+// user page table. not specially mapped in the kernel page table.
+// uservec in trampoline.S saves user registers in the trapframe,
+// then initializes registers from the trapframe's
+// kernel_sp, kernel_hartid, kernel_satp, and jumps to kernel_trap.
+// usertrapret() and userret in trampoline.S set up
+// the trapframe's kernel_*, restore user registers from the
+// trapframe, switch to the user page table, and enter user space.
+// the trapframe includes callee-saved user registers like s0-s11 because the
+// return-to-user path via usertrapret() doesn't return through
+// the entire kernel call stack.
+struct trapframe {
+  /*   0 */ uint64 kernel_satp;   // kernel page table
+  /*   8 */ uint64 kernel_sp;     // top of process's kernel stack
+  /*  16 */ uint64 kernel_trap;   // usertrap()
+  /*  24 */ uint64 epc;           // saved user program counter
+  /*  32 */ uint64 kernel_hartid; // saved kernel tp
+  /*  40 */ uint64 ra;
+  /*  48 */ uint64 sp;
+  /*  56 */ uint64 gp;
+  /*  64 */ uint64 tp;
+  /*  72 */ uint64 t0;
+  /*  80 */ uint64 t1;
+  /*  88 */ uint64 t2;
+  /*  96 */ uint64 s0;
+  /* 104 */ uint64 s1;
+  /* 112 */ uint64 a0;
+  /* 120 */ uint64 a1;
+  /* 128 */ uint64 a2;
+  /* 136 */ uint64 a3;
+  /* 144 */ uint64 a4;
+  /* 152 */ uint64 a5;
+  /* 160 */ uint64 a6;
+  /* 168 */ uint64 a7;
+  /* 176 */ uint64 s2;
+  /* 184 */ uint64 s3;
+  /* 192 */ uint64 s4;
+  /* 200 */ uint64 s5;
+  /* 208 */ uint64 s6;
+  /* 216 */ uint64 s7;
+  /* 224 */ uint64 s8;
+  /* 232 */ uint64 s9;
+  /* 240 */ uint64 s10;
+  /* 248 */ uint64 s11;
+  /* 256 */ uint64 t3;
+  /* 264 */ uint64 t4;
+  /* 272 */ uint64 t5;
+  /* 280 */ uint64 t6;
+};
+
+// Task 2.1: multi-level feedback queue mode (make SCHEDPOLICY=MLFQ)
+#define NMLFQ           4                   // number of levels, 0 is the highest
+#define MLFQ_QUANTUM(l) (1 << (2 * (l)))    // 1, 4, 16, 64 ticks
+#define MLFQ_BOOST      100                 // ticks between priority boosts
+
+// timer ticks a process may run before it is preempted.
+#ifdef SCHED_MLFQ
+#define QUANTUM(p) MLFQ_QUANTUM((p)->level)
+#else
+#define QUANTUM(p) ((p)->priority)
+#endif
+
+// Task 2.1: time CSR cycles per tick, about a tenth of a second.
+#define TICK_CYCLES 1000000
+
+// MLFQ: the current boost period. Taken from the time CSR, since a
+// tickless kernel only brings ticks up to date when a CPU wakes up.
+#define MLFQ_EPOCH() ((uint)(r_time() / ((uint64)MLFQ_BOOST * TICK_CYCLES)))
+
+// CPU time is charged in time CSR cycles when a process is switched
+// out, not counted in ticks, so a process that gives up the CPU just
+// before every timer interrupt still uses up its quantum.
+#define QUANTUM_CYCLES(p) ((uint64)QUANTUM(p) * TICK_CYCLES)
+
+// quantum p has used so far, including the current run.
+// p must be RUNNING.
+#define USED(p) ((p)->used + (r_time() - (p)->runstart))
+
+// has p used up its quantum after using u cycles of it? Ticks land
+// at arbitrary points in a run, so without TICKLESS a quantum with
+// less than half a tick left counts as used up. On average p then
+// runs for its quantum, not half a tick more.
+#ifdef TICKLESS
+#define SPENT(p, u) ((u) >= QUANTUM_CYCLES(p))
+#else
+#define SPENT(p, u) ((u) + TICK_CYCLES / 2 >= QUANTUM_CYCLES(p))
+#endif
+
+enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
+
+// Per-process state
+struct proc {
+  struct spinlock lock;
+
+  // p->lock must be held when using these:
+  enum procstate state;        // Process state
+  void *chan;                  // If non-zero, sleeping on chan
+  int killed;                  // If non-zero, have been killed
+  int xstate;                  // Exit status to be returned to parent's wait
+  int pid;                     // Process ID
+  int home;                    // CPU whose run queue p is placed on
+
+  // the home CPU's run queue lock must be held when using this:
+  struct proc *rq_next;        // Next process on the run queue
+
+  // wait_lock must be held when using this:
+  struct proc *parent;         // Parent process
+
+  // these are private to the process, so p->lock need not be held.
+  uint64 kstack;               // Virtual address of kernel stack
+  uint64 sz;                   // Size of process memory (bytes)
+  pagetable_t pagetable;       // User page table
+  struct trapframe *trapframe; // data page for trampoline.S
+  struct context context;      // swtch() here to run process
+  struct file *ofile[NOFILE];  // Open files
+  struct inode *cwd;           // Current directory
+  char name[16];               // Process name (debugging)
+
+  // for Task 2.1
+  int priority;               // Process priority
+  uint64 used;               // time CSR cycles of its quantum used so far
+  int level;                 // MLFQ level, 0 is the highest
+  uint epoch;                // MLFQ boost period level was last reset in
+  uint64 runstart;           // time CSR when last picked
+  int affinity;              // mask of CPUs it may run on (setaffinity)
+
+  // EDF class (sched_setdeadline). edfcpu's edfq lock must be held
+  // when using these, and p->lock as well to change edf:
+  int edf;                   // utilisation reserved, per mille; 0 if not EDF
+  int edfcpu;                // CPU it was admitted on, the only one it runs on
+  struct proc *edfnext;      // next on that CPU's EDF list
+  uint64 edfrun;             // runtime per period, time CSR cycles
+  uint64 edfperiod;          // period, time CSR cycles
+  uint64 deadline;           // end of the current period, time CSR
+  uint64 budget;             // runtime left in the current period
+
+  // scheduling statistics (pstat.h)
+  int lastcpu;               // CPU it last ran on
+  int nsched;                // times picked by the scheduler
+  int nvcsw;                 // voluntary switches (sleep)
+  int nivcsw;                // involuntary switches (yield)
+  uint64 cputime;            // time CSR cycles spent RUNNING
+  uint64 childtime;          // cputime of the children it has waited for
+  uint64 waittime;           // time CSR cycles spent RUNNABLE
+  int woken;                 // made RUNNABLE by wakeup(), not preempted
+  int wakelat[PSTAT_NLAT];   // wakeup-to-run latency histogram
+  uint64 readytime;          // time CSR when last made RUNNABLE
+};
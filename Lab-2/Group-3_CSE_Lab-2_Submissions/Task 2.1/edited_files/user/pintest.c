@@ -0,0 +1,87 @@
+// Task 2.1: wakeups of a process pinned to an otherwise idle CPU.
+//
+// usage: pintest [rounds]   (default 20)
+//
+// The parent is pinned to CPU 0 and its child to CPU 1, where
+// nothing else runs. Each round the parent spins for a while, so
+// CPU 1 goes idle (in TICKLESS mode with its tick stopped), then
+// wakes the child by writing a byte to a pipe and waits for the
+// reply. A lost wakeup leaves the child queued until some other
+// interrupt reaches CPU 1, which shows up as rounds of a tick or
+// more, or as a hang. Needs at least 2 CPUs.
+//
+// First it checks that setaffinity() refuses masks without a
+// started CPU: an empty one, and CPU 7, which make qemu (CPUS=3)
+// doesn't start. Accepting the latter would leave pintest queued
+// on a hart that never runs it.
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define SPIN 500000
+
+int
+main(int argc, char *argv[])
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 20;
+  int ping[2], pong[2];
+  char c = 'x';
+
+  if(rounds < 1){
+    fprintf(2, "usage: pintest [rounds]\n");
+    exit(1);
+  }
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    fprintf(2, "pintest: pipe failed\n");
+    exit(1);
+  }
+  if(setaffinity(0, 0) != -1){
+    fprintf(2, "pintest: setaffinity accepted an empty mask: FAIL\n");
+    exit(1);
+  }
+  // if 8 harts did start, this moves pintest to CPU 7 and back.
+  if(setaffinity(0, 1 << 7) < 0)
+    printf("pintest: CPU 7 not started, mask refused\n");
+  if(setaffinity(0, 1 << 0) < 0){
+    fprintf(2, "pintest: setaffinity failed\n");
+    exit(1);
+  }
+
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "pintest: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    if(setaffinity(0, 1 << 1) < 0){
+      fprintf(2, "pintest: can't pin to CPU 1\n");
+      exit(1);
+    }
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+
+  // let the child move to CPU 1 and block.
+  sleep(1);
+
+  int t0 = uptime();
+  for(int i = 0; i < rounds; i++){
+    for(volatile int j = 0; j < SPIN; j++)
+      ;
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1){
+      fprintf(2, "pintest: child went away\n");
+      exit(1);
+    }
+  }
+  int ticks = uptime() - t0;
+  close(ping[1]);
+  wait(0);
+
+  // the spinning takes far less than a tick a round; a lost
+  // wakeup costs at least a tick.
+  printf("pintest: %d rounds in %d ticks: %s\n", rounds, ticks,
+         ticks < rounds ? "OK" : "FAIL");
+  exit(ticks < rounds ? 0 : 1);
+}
@@ -0,0 +1,39 @@
+// Task 2.1: run a command and report the CPU time it used, from
+// getrusage(RUSAGE_CHILDREN) before and after it is waited for.
+// usage: time cmd [args...]
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+int
+main(int argc, char *argv[])
+{
+  struct rusage before, after;
+
+  if(argc < 2){
+    fprintf(2, "usage: time cmd [args...]\n");
+    exit(1);
+  }
+
+  getrusage(RUSAGE_CHILDREN, &before);
+  int start = uptime();
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "time: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "time: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  int ticks = uptime() - start;
+  getrusage(RUSAGE_CHILDREN, &after);
+
+  // cpu time of everything the command waited for is included.
+  uint64 us = (after.cputime - before.cputime) / 1000;
+  printf("%s: real %d ms, cpu %d us\n", argv[1], ticks * 100, (int)us);
+  exit(0);
+}
@@ -39,4 +39,10 @@ entry("uptime");
 
 # Task 2.1
 entry("setpriority");
-entry("getpriority");
\ No newline at end of file
+entry("getpriority");
+entry("getprocstats");
+entry("getallprocstats");
+entry("setaffinity");
+entry("getaffinity");
+entry("sched_setdeadline");
+entry("getrusage");
\ No newline at end of file
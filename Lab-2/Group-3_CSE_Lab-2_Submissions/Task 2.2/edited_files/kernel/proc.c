@@ -1,726 +1,1612 @@
-#include "types.h"
-#include "param.h"
-#include "memlayout.h"
-#include "riscv.h"
-#include "spinlock.h"
-#include "proc.h"
-#include "defs.h"
-
-struct cpu cpus[NCPU];
-
-struct proc proc[NPROC];
-
-struct proc *initproc;
-
-int nextpid = 1;
-struct spinlock pid_lock;
-
-// Pseudo random number generator for Task 2.2
-static uint64 randstate = 88172645463393265ULL; // any nonzero seed
-static inline uint rand32(void) {
-  // LCG parameters from Numerical Recipes (scaled for 64-bit state)
-  randstate = randstate * 6364136223846793005ULL + 1ULL;
-  return (uint)(randstate >> 33); // upper 31 bits
-}
-
-extern void forkret(void);
-static void freeproc(struct proc *p);
-
-extern char trampoline[]; // trampoline.S
-
-// helps ensure that wakeups of wait()ing
-// parents are not lost. helps obey the
-// memory model when using p->parent.
-// must be acquired before any p->lock.
-struct spinlock wait_lock;
-
-// Allocate a page for each process's kernel stack.
-// Map it high in memory, followed by an invalid
-// guard page.
-void
-proc_mapstacks(pagetable_t kpgtbl)
-{
-  struct proc *p;
-  
-  for(p = proc; p < &proc[NPROC]; p++) {
-    char *pa = kalloc();
-    if(pa == 0)
-      panic("kalloc");
-    uint64 va = KSTACK((int) (p - proc));
-    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
-  }
-}
-
-// initialize the proc table.
-void
-procinit(void)
-{
-  struct proc *p;
-  
-  initlock(&pid_lock, "nextpid");
-  initlock(&wait_lock, "wait_lock");
-  for(p = proc; p < &proc[NPROC]; p++) {
-      initlock(&p->lock, "proc");
-      p->state = UNUSED;
-      p->kstack = KSTACK((int) (p - proc));
-  }
-}
-
-// Must be called with interrupts disabled,
-// to prevent race with process being moved
-// to a different CPU.
-int
-cpuid()
-{
-  int id = r_tp();
-  return id;
-}
-
-// Return this CPU's cpu struct.
-// Interrupts must be disabled.
-struct cpu*
-mycpu(void)
-{
-  int id = cpuid();
-  struct cpu *c = &cpus[id];
-  return c;
-}
-
-// Return the current struct proc *, or zero if none.
-struct proc*
-myproc(void)
-{
-  push_off();
-  struct cpu *c = mycpu();
-  struct proc *p = c->proc;
-  pop_off();
-  return p;
-}
-
-int
-allocpid()
-{
-  int pid;
-  
-  acquire(&pid_lock);
-  pid = nextpid;
-  nextpid = nextpid + 1;
-  release(&pid_lock);
-
-  return pid;
-}
-
-// Look in the process table for an UNUSED proc.
-// If found, initialize state required to run in the kernel,
-// and return with p->lock held.
-// If there are no free procs, or a memory allocation fails, return 0.
-static struct proc*
-allocproc(void)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->state == UNUSED) {
-      goto found;
-    } else {
-      release(&p->lock);
-    }
-  }
-  return 0;
-
-found:
-  p->pid = allocpid();
-  p->state = USED;
-
-  p->tickets = 10; // Task 2.2
-
-  // Allocate a trapframe page.
-  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // An empty user page table.
-  p->pagetable = proc_pagetable(p);
-  if(p->pagetable == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // Set up new context to start executing at forkret,
-  // which returns to user space.
-  memset(&p->context, 0, sizeof(p->context));
-  p->context.ra = (uint64)forkret;
-  p->context.sp = p->kstack + PGSIZE;
-
-  return p;
-}
-
-// free a proc structure and the data hanging from it,
-// including user pages.
-// p->lock must be held.
-static void
-freeproc(struct proc *p)
-{
-  if(p->trapframe)
-    kfree((void*)p->trapframe);
-  p->trapframe = 0;
-  if(p->pagetable)
-    proc_freepagetable(p->pagetable, p->sz);
-  p->pagetable = 0;
-  p->sz = 0;
-  p->pid = 0;
-  p->parent = 0;
-  p->name[0] = 0;
-  p->chan = 0;
-  p->killed = 0;
-  p->xstate = 0;
-  p->state = UNUSED;
-}
-
-// Create a user page table for a given process, with no user memory,
-// but with trampoline and trapframe pages.
-pagetable_t
-proc_pagetable(struct proc *p)
-{
-  pagetable_t pagetable;
-
-  // An empty page table.
-  pagetable = uvmcreate();
-  if(pagetable == 0)
-    return 0;
-
-  // map the trampoline code (for system call return)
-  // at the highest user virtual address.
-  // only the supervisor uses it, on the way
-  // to/from user space, so not PTE_U.
-  if(mappages(pagetable, TRAMPOLINE, PGSIZE,
-              (uint64)trampoline, PTE_R | PTE_X) < 0){
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  // map the trapframe page just below the trampoline page, for
-  // trampoline.S.
-  if(mappages(pagetable, TRAPFRAME, PGSIZE,
-              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
-    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  return pagetable;
-}
-
-// Free a process's page table, and free the
-// physical memory it refers to.
-void
-proc_freepagetable(pagetable_t pagetable, uint64 sz)
-{
-  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-  uvmunmap(pagetable, TRAPFRAME, 1, 0);
-  uvmfree(pagetable, sz);
-}
-
-// a user program that calls exec("/init")
-// assembled from ../user/initcode.S
-// od -t xC ../user/initcode
-uchar initcode[] = {
-  0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0x45, 0x02,
-  0x97, 0x05, 0x00, 0x00, 0x93, 0x85, 0x35, 0x02,
-  0x93, 0x08, 0x70, 0x00, 0x73, 0x00, 0x00, 0x00,
-  0x93, 0x08, 0x20, 0x00, 0x73, 0x00, 0x00, 0x00,
-  0xef, 0xf0, 0x9f, 0xff, 0x2f, 0x69, 0x6e, 0x69,
-  0x74, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00
-};
-
-// Set up first user process.
-void
-userinit(void)
-{
-  struct proc *p;
-
-  p = allocproc();
-  initproc = p;
-  
-  // allocate one user page and copy initcode's instructions
-  // and data into it.
-  uvmfirst(p->pagetable, initcode, sizeof(initcode));
-  p->sz = PGSIZE;
-
-  // prepare for the very first "return" from kernel to user.
-  p->trapframe->epc = 0;      // user program counter
-  p->trapframe->sp = PGSIZE;  // user stack pointer
-
-  safestrcpy(p->name, "initcode", sizeof(p->name));
-  p->cwd = namei("/");
-
-  p->state = RUNNABLE;
-
-  release(&p->lock);
-}
-
-// Grow or shrink user memory by n bytes.
-// Return 0 on success, -1 on failure.
-int
-growproc(int n)
-{
-  uint64 sz;
-  struct proc *p = myproc();
-
-  sz = p->sz;
-  if(n > 0){
-    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
-      return -1;
-    }
-  } else if(n < 0){
-    sz = uvmdealloc(p->pagetable, sz, sz + n);
-  }
-  p->sz = sz;
-  return 0;
-}
-
-// Create a new process, copying the parent.
-// Sets up child kernel stack to return as if from fork() system call.
-int
-fork(void)
-{
-  int i, pid;
-  struct proc *np;
-  struct proc *p = myproc();
-
-  // Allocate process.
-  if((np = allocproc()) == 0){
-    return -1;
-  }
-
-  // Task 2.2
-  np->tickets = p->tickets;
-
-  // Copy user memory from parent to child.
-  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
-    freeproc(np);
-    release(&np->lock);
-    return -1;
-  }
-  np->sz = p->sz;
-
-  // copy saved user registers.
-  *(np->trapframe) = *(p->trapframe);
-
-  // Cause fork to return 0 in the child.
-  np->trapframe->a0 = 0;
-
-  // increment reference counts on open file descriptors.
-  for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);
-  np->cwd = idup(p->cwd);
-
-  safestrcpy(np->name, p->name, sizeof(p->name));
-
-  pid = np->pid;
-
-  release(&np->lock);
-
-  acquire(&wait_lock);
-  np->parent = p;
-  release(&wait_lock);
-
-  acquire(&np->lock);
-  np->state = RUNNABLE;
-  release(&np->lock);
-
-  return pid;
-}
-
-// Pass p's abandoned children to init.
-// Caller must hold wait_lock.
-void
-reparent(struct proc *p)
-{
-  struct proc *pp;
-
-  for(pp = proc; pp < &proc[NPROC]; pp++){
-    if(pp->parent == p){
-      pp->parent = initproc;
-      wakeup(initproc);
-    }
-  }
-}
-
-// Exit the current process.  Does not return.
-// An exited process remains in the zombie state
-// until its parent calls wait().
-void
-exit(int status)
-{
-  struct proc *p = myproc();
-
-  if(p == initproc)
-    panic("init exiting");
-
-  // Close all open files.
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);
-      p->ofile[fd] = 0;
-    }
-  }
-
-  begin_op();
-  iput(p->cwd);
-  end_op();
-  p->cwd = 0;
-
-  acquire(&wait_lock);
-
-  // Give any children to init.
-  reparent(p);
-
-  // Parent might be sleeping in wait().
-  wakeup(p->parent);
-  
-  acquire(&p->lock);
-
-  p->xstate = status;
-  p->state = ZOMBIE;
-
-  release(&wait_lock);
-
-  // Jump into the scheduler, never to return.
-  sched();
-  panic("zombie exit");
-}
-
-// Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
-int
-wait(uint64 addr)
-{
-  struct proc *pp;
-  int havekids, pid;
-  struct proc *p = myproc();
-
-  acquire(&wait_lock);
-
-  for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){
-        // make sure the child isn't still in exit() or swtch().
-        acquire(&pp->lock);
-
-        havekids = 1;
-        if(pp->state == ZOMBIE){
-          // Found one.
-          pid = pp->pid;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
-                                  sizeof(pp->xstate)) < 0) {
-            release(&pp->lock);
-            release(&wait_lock);
-            return -1;
-          }
-          freeproc(pp);
-          release(&pp->lock);
-          release(&wait_lock);
-          return pid;
-        }
-        release(&pp->lock);
-      }
-    }
-
-    // No point waiting if we don't have any children.
-    if(!havekids || killed(p)){
-      release(&wait_lock);
-      return -1;
-    }
-    
-    // Wait for a child to exit.
-    sleep(p, &wait_lock);  //DOC: wait-sleep
-  }
-}
-
-// Per-CPU process scheduler.
-// Each CPU calls scheduler() after setting itself up.
-
-void
-scheduler(void)
-{
-  struct proc *p;
-  struct cpu *c = mycpu();
-
-  c->proc = 0;
-  for(;;){
-    // The most recent process to run may have had interrupts
-    // turned off; enable them to avoid a deadlock if all
-    // processes are waiting. Then turn them back off
-    // to avoid a possible race between an interrupt
-    // and wfi.
-    intr_on();
-    intr_off();
-
-    int found = 0, total = 0;
-
-    for(p = proc; p < &proc[NPROC]; p++){
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        int t = (p->tickets < 1) ? 1 : p->tickets;
-        total += t;
-        found = 1;
-      }
-      release(&p->lock);
-    }
-
-    if(found == 0){
-      asm volatile("wfi");
-      continue;
-    }
-
-    uint winner = rand32() % (uint)total; // the lottery ticket no.
-
-    int prefix = 0, scheduled = 0;
-    for(p = proc; p < &proc[NPROC]; p++){
-      acquire(&p->lock);
-      if(p->state == RUNNABLE){
-        int t = (p->tickets < 1) ? 1 : p->tickets;
-        if(winner < (uint)(prefix + t-1))
-        {
-          p->state = RUNNING;
-          c->proc = p;
-          swtch(&c->context, &p->context);
-          c->proc = 0;
-          scheduled = 1;
-          release(&p->lock);
-          break;
-        }
-        prefix += t;
-      }
-      release(&p->lock);
-    }
-
-    if(scheduled == 0) {
-      asm volatile("wfi");
-    }
-  }
-}
-
-// Switch to scheduler.  Must hold only p->lock
-// and have changed proc->state. Saves and restores
-// intena because intena is a property of this
-// kernel thread, not this CPU. It should
-// be proc->intena and proc->noff, but that would
-// break in the few places where a lock is held but
-// there's no process.
-void
-sched(void)
-{
-  int intena;
-  struct proc *p = myproc();
-
-  if(!holding(&p->lock))
-    panic("sched p->lock");
-  if(mycpu()->noff != 1)
-    panic("sched locks");
-  if(p->state == RUNNING)
-    panic("sched RUNNING");
-  if(intr_get())
-    panic("sched interruptible");
-
-  intena = mycpu()->intena;
-  swtch(&p->context, &mycpu()->context);
-  mycpu()->intena = intena;
-}
-
-// Give up the CPU for one scheduling round.
-void
-yield(void)
-{
-  struct proc *p = myproc();
-  acquire(&p->lock);
-  p->state = RUNNABLE;
-  sched();
-  release(&p->lock);
-}
-
-// A fork child's very first scheduling by scheduler()
-// will swtch to forkret.
-void
-forkret(void)
-{
-  static int first = 1;
-
-  // Still holding p->lock from scheduler.
-  release(&myproc()->lock);
-
-  if (first) {
-    // File system initialization must be run in the context of a
-    // regular process (e.g., because it calls sleep), and thus cannot
-    // be run from main().
-    fsinit(ROOTDEV);
-
-    first = 0;
-    // ensure other cores see first=0.
-    __sync_synchronize();
-  }
-
-  usertrapret();
-}
-
-// Sleep on wait channel chan, releasing condition lock lk.
-// Re-acquires lk when awakened.
-void
-sleep(void *chan, struct spinlock *lk)
-{
-  struct proc *p = myproc();
-  
-  // Must acquire p->lock in order to
-  // change p->state and then call sched.
-  // Once we hold p->lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
-  // so it's okay to release lk.
-
-  acquire(&p->lock);  //DOC: sleeplock1
-  release(lk);
-
-  // Go to sleep.
-  p->chan = chan;
-  p->state = SLEEPING;
-
-  sched();
-
-  // Tidy up.
-  p->chan = 0;
-
-  // Reacquire original lock.
-  release(&p->lock);
-  acquire(lk);
-}
-
-// Wake up all processes sleeping on wait channel chan.
-// Caller should hold the condition lock.
-void
-wakeup(void *chan)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
-      acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-    }
-  }
-}
-
-// Kill the process with the given pid.
-// The victim won't exit until it tries to return
-// to user space (see usertrap() in trap.c).
-int
-kill(int pid)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++){
-    acquire(&p->lock);
-    if(p->pid == pid){
-      p->killed = 1;
-      if(p->state == SLEEPING){
-        // Wake process from sleep().
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-      return 0;
-    }
-    release(&p->lock);
-  }
-  return -1;
-}
-
-void
-setkilled(struct proc *p)
-{
-  acquire(&p->lock);
-  p->killed = 1;
-  release(&p->lock);
-}
-
-int
-killed(struct proc *p)
-{
-  int k;
-  
-  acquire(&p->lock);
-  k = p->killed;
-  release(&p->lock);
-  return k;
-}
-
-// Copy to either a user address, or kernel address,
-// depending on usr_dst.
-// Returns 0 on success, -1 on error.
-int
-either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_dst){
-    return copyout(p->pagetable, dst, src, len);
-  } else {
-    memmove((char *)dst, src, len);
-    return 0;
-  }
-}
-
-// Copy from either a user address, or kernel address,
-// depending on usr_src.
-// Returns 0 on success, -1 on error.
-int
-either_copyin(void *dst, int user_src, uint64 src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_src){
-    return copyin(p->pagetable, dst, src, len);
-  } else {
-    memmove(dst, (char*)src, len);
-    return 0;
-  }
-}
-
-// Print a process listing to console.  For debugging.
-// Runs when user types ^P on console.
-// No lock to avoid wedging a stuck machine further.
-void
-procdump(void)
-{
-  static char *states[] = {
-  [UNUSED]    "unused",
-  [USED]      "used",
-  [SLEEPING]  "sleep ",
-  [RUNNABLE]  "runble",
-  [RUNNING]   "run   ",
-  [ZOMBIE]    "zombie"
-  };
-  struct proc *p;
-  char *state;
-
-  printf("\n");
-  for(p = proc; p < &proc[NPROC]; p++){
-    if(p->state == UNUSED)
-      continue;
-    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
-      state = states[p->state];
-    else
-      state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
-    printf("\n");
-  }
-}
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "pstat.h"
+
+struct cpu cpus[NCPU];
+
+struct proc proc[NPROC];
+
+struct proc *initproc;
+
+int nextpid = 1;
+struct spinlock pid_lock;
+
+// tickets a process holds in the draw (or the stride divisor),
+// including compensation tickets from leaving its last quantum early.
+#define TICKETS(p) ((p)->comptickets ? (p)->comptickets : \
+                    ((p)->tickets < 1) ? 1 : (p)->tickets)
+
+// 1/f is capped so that a process that sleeps right after
+// being picked doesn't get an unbounded number of tickets.
+#define MAXCOMP 100
+
+// Most tickets a process can hold in the draw, compensation and
+// currency conversion included, so that the run queues' int sums
+// of NPROC processes can't overflow.
+#define MAXTICKETS (1 << 20)
+
+// Task 2.2: ticket currencies. A process in group 0 holds its
+// tickets in the base currency, as before. A group created with
+// tgroup() holds a budget in the base currency instead, which its
+// members share in proportion to their own tickets, so forking more
+// members doesn't give the group more CPU. The draw is hierarchical
+// (pick a group by budget, then a member by tickets), but with
+// per-CPU queues and stealing it is held as one draw over each
+// process's base value, budget * tickets / active, which gives
+// every process the same odds. The value is worked out when the
+// process is queued, so it lags changes in its group's active sum
+// by at most one quantum.
+#define NTGROUP 16
+
+// Lock order: p->lock before tgroup_lock.
+static struct spinlock tgroup_lock;
+static struct tgroup {
+  int budget;            // base tickets the group holds, 0 if unused
+  int active;            // sum of its RUNNABLE/RUNNING members' tickets
+  int nmembers;          // processes in it, it is freed at 0
+} tgroups[NTGROUP];
+
+// p's tickets in the base currency, including compensation.
+// p->lock must be held.
+static int
+basetickets(struct proc *p)
+{
+  int t = TICKETS(p);
+
+  if(p->tgroup == 0)
+    return t;
+  acquire(&tgroup_lock);
+  struct tgroup *g = &tgroups[p->tgroup];
+  int active = (g->active < 1) ? 1 : g->active;
+  uint64 b = (uint64)g->budget * t / active;
+  t = (b > MAXTICKETS) ? MAXTICKETS : (int)b;
+  release(&tgroup_lock);
+  return (t < 1) ? 1 : t;
+}
+
+// Count p's tickets in its group's active sum, or take them out.
+// p->lock must be held.
+static void
+tgroup_activate(struct proc *p)
+{
+  if(p->tgroup == 0 || p->gactive)
+    return;
+  p->gactive = (p->tickets < 1) ? 1 : p->tickets;
+  acquire(&tgroup_lock);
+  tgroups[p->tgroup].active += p->gactive;
+  release(&tgroup_lock);
+}
+
+static void
+tgroup_deactivate(struct proc *p)
+{
+  if(p->gactive == 0)
+    return;
+  acquire(&tgroup_lock);
+  tgroups[p->tgroup].active -= p->gactive;
+  release(&tgroup_lock);
+  p->gactive = 0;
+}
+
+// Take p out of its group, freeing the group if p was its last member.
+// p->lock must be held.
+static void
+tgroup_leave(struct proc *p)
+{
+  tgroup_deactivate(p);
+  if(p->tgroup == 0)
+    return;
+  acquire(&tgroup_lock);
+  if(--tgroups[p->tgroup].nmembers == 0)
+    tgroups[p->tgroup].budget = 0;
+  release(&tgroup_lock);
+  p->tgroup = 0;
+}
+
+#ifdef SCHED_STRIDE
+
+// Task 2.2 (stride mode, make SCHEDPOLICY=STRIDE): each process
+// advances its pass by STRIDE1/tickets every time it is picked and
+// the queue always runs the lowest pass, so CPU share tracks tickets
+// with an error of at most one quantum instead of a random one.
+#define STRIDE1 (1 << 20)
+
+// per-CPU run queues: a binary min-heap of proc[] slots ordered by
+// pass. The pass is copied into the queue so ordering never needs
+// the queued process's lock.
+// Lock order: p->lock before runq lock.
+static struct runq {
+  struct spinlock lock;
+  uint64 vtime;          // pass of the process picked last
+  uint64 pass[NPROC];    // pass of each queued slot
+  int heap[NPROC];       // heap[0] has the smallest pass
+  int nrunnable;         // entries in heap[]
+} runqs[NCPU];
+
+// Add p to rq. A process rejoining after a sleep (or arriving from
+// another CPU) has its pass moved into [vtime, vtime + stride], so it
+// neither starves the queue nor waits for the others to catch up.
+// p->lock must be held.
+static void
+runq_insert(struct runq *rq, struct proc *p)
+{
+  int slot = p - proc;
+  uint64 stride = STRIDE1 / basetickets(p);
+
+  acquire(&rq->lock);
+  if(p->pass < rq->vtime)
+    p->pass = rq->vtime;
+  else if(p->pass > rq->vtime + stride)
+    p->pass = rq->vtime + stride;
+  rq->pass[slot] = p->pass;
+
+  int i = rq->nrunnable++;
+  while(i > 0 && rq->pass[rq->heap[(i - 1) / 2]] > p->pass){
+    rq->heap[i] = rq->heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  rq->heap[i] = slot;
+  release(&rq->lock);
+}
+
+// Take heap[i] out of rq: the last entry fills the hole and
+// moves down, or up if it has a smaller pass than the hole's
+// parent (only possible when i isn't the root).
+// rq->lock must be held.
+static void
+runq_remove(struct runq *rq, int i)
+{
+  int last = rq->heap[--rq->nrunnable];
+
+  if(i == rq->nrunnable)
+    return;
+  while(i > 0 && rq->pass[rq->heap[(i - 1) / 2]] > rq->pass[last]){
+    rq->heap[i] = rq->heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  for(;;){
+    int c = 2 * i + 1;
+    if(c >= rq->nrunnable)
+      break;
+    if(c + 1 < rq->nrunnable && rq->pass[rq->heap[c + 1]] < rq->pass[rq->heap[c]])
+      c++;
+    if(rq->pass[rq->heap[c]] >= rq->pass[last])
+      break;
+    rq->heap[i] = rq->heap[c];
+    i = c;
+  }
+  rq->heap[i] = last;
+}
+
+// Take the slot with the smallest pass out of rq. If cpu >= 0
+// only slots whose affinity allows cpu count, which needs a scan
+// of the heap instead of taking the root.
+// Returns -1 if there is no such slot.
+static int
+runq_draw(struct runq *rq, int cpu)
+{
+  int i = -1;
+
+  acquire(&rq->lock);
+  if(cpu < 0){
+    if(rq->nrunnable > 0)
+      i = 0;
+  } else {
+    for(int j = 0; j < rq->nrunnable; j++){
+      int slot = rq->heap[j];
+      if((proc[slot].affinity & (1 << cpu)) &&
+         (i < 0 || rq->pass[slot] < rq->pass[rq->heap[i]]))
+        i = j;
+    }
+  }
+  if(i < 0){
+    release(&rq->lock);
+    return -1;
+  }
+
+  int slot = rq->heap[i];
+  if(cpu < 0)
+    rq->vtime = rq->pass[slot];
+  runq_remove(rq, i);
+
+  release(&rq->lock);
+  return slot;
+}
+
+#else
+
+// Pseudo random number generator for Task 2.2
+// each run queue keeps its own state so draws on
+// different CPUs don't share a cache line.
+static inline uint rand32(uint64 *randstate) {
+  // LCG parameters from Numerical Recipes (scaled for 64-bit state)
+  *randstate = *randstate * 6364136223846793005ULL + 1ULL;
+  return (uint)(*randstate >> 33); // upper 31 bits
+}
+
+// Task 2.2: per-CPU run queues. Each queue is a Fenwick tree indexed
+// by proc[] slot; a slot holds the tickets of a RUNNABLE process whose
+// p->home is that CPU and 0 otherwise, so drawing a winner is
+// O(log NPROC) and only touches the local queue's lock.
+// Lock order: p->lock before runq lock.
+static struct runq {
+  struct spinlock lock;
+  uint64 randstate;      // LCG state, any nonzero seed
+  int weight[NPROC];     // current contribution of each slot
+  int tree[NPROC + 1];   // 1-indexed Fenwick tree over weight[]
+  int total;             // sum of weight[]
+  int nrunnable;         // slots with weight > 0
+} runqs[NCPU];
+
+static int topbit;       // largest power of two <= NPROC
+
+// rq->lock must be held.
+static void
+runq_add(struct runq *rq, int slot, int delta)
+{
+  for(int i = slot + 1; i <= NPROC; i += i & -i)
+    rq->tree[i] += delta;
+  rq->total += delta;
+}
+
+// Set the number of tickets proc[slot] holds in rq's draw.
+static void
+runq_set(struct runq *rq, int slot, int w)
+{
+  acquire(&rq->lock);
+  if(w != rq->weight[slot]){
+    if(rq->weight[slot] == 0)
+      rq->nrunnable++;
+    else if(w == 0)
+      rq->nrunnable--;
+    runq_add(rq, slot, w - rq->weight[slot]);
+    rq->weight[slot] = w;
+  }
+  release(&rq->lock);
+}
+
+// Enter p's tickets into rq's draw.
+// p->lock must be held.
+static void
+runq_insert(struct runq *rq, struct proc *p)
+{
+  runq_set(rq, p - proc, basetickets(p));
+}
+
+// Draw a lottery among the slots of rq whose affinity allows
+// cpu, by a linear scan since the tree only has the sums over
+// all slots. rq->lock must be held.
+// Returns -1 if no slot is allowed on cpu.
+static int
+runq_drawfor(struct runq *rq, int cpu)
+{
+  uint total = 0;
+
+  for(int i = 0; i < NPROC; i++)
+    if(rq->weight[i] > 0 && (proc[i].affinity & (1 << cpu)))
+      total += rq->weight[i];
+  if(total == 0)
+    return -1;
+
+  uint winner = rand32(&rq->randstate) % total;
+  for(int i = 0; i < NPROC; i++){
+    if(rq->weight[i] > 0 && (proc[i].affinity & (1 << cpu))){
+      if(winner < (uint)rq->weight[i])
+        return i;
+      winner -= rq->weight[i];
+    }
+  }
+  return -1;
+}
+
+// Draw a winning ticket from rq and take the winner's slot out of
+// the tree, so no other CPU can draw it too. If cpu >= 0 only
+// slots whose affinity allows cpu take part.
+// Returns -1 if there is no such slot.
+static int
+runq_draw(struct runq *rq, int cpu)
+{
+  int pos = 0;
+
+  acquire(&rq->lock);
+  if(rq->total == 0){
+    release(&rq->lock);
+    return -1;
+  }
+
+  if(cpu >= 0){
+    pos = runq_drawfor(rq, cpu);
+    if(pos < 0){
+      release(&rq->lock);
+      return -1;
+    }
+  } else {
+    uint winner = rand32(&rq->randstate) % (uint)rq->total; // the lottery ticket no.
+
+    // descend the tree: pos ends as the last slot whose prefix sum
+    // is <= winner, i.e. the slot just before the winning one.
+    for(int step = topbit; step > 0; step >>= 1){
+      if(pos + step <= NPROC && (uint)rq->tree[pos + step] <= winner){
+        pos += step;
+        winner -= rq->tree[pos];
+      }
+    }
+  }
+
+  runq_add(rq, pos, -rq->weight[pos]);
+  rq->weight[pos] = 0;
+  rq->nrunnable--;
+  release(&rq->lock);
+  return pos;
+}
+
+#endif // SCHED_STRIDE
+
+// Called by an idle CPU whose own queue is empty: pick from
+// the busiest other queue instead, among the processes allowed
+// to run on self. If the busiest queue only has processes
+// pinned elsewhere, try the next busiest.
+// nrunnable and affinity are read without locks; a stale read
+// only means a wasted draw, and scheduler() rechecks affinity.
+static int
+runq_steal(int self)
+{
+  int tried = 1 << self;
+
+  for(;;){
+    int victim = -1, most = 0;
+    for(int i = 0; i < NCPU; i++){
+      if(!(tried & (1 << i)) && runqs[i].nrunnable > most){
+        most = runqs[i].nrunnable;
+        victim = i;
+      }
+    }
+    if(victim < 0)
+      return -1;
+    int slot = runq_draw(&runqs[victim], self);
+    if(slot >= 0)
+      return slot;
+    tried |= 1 << victim;
+  }
+}
+
+// Task 2.2: waking idle harts. A hart with nothing to run sets its
+// bit in idlemask and sleeps in wfi. Whoever makes a process
+// RUNNABLE clears the bit of a hart that should run it and sends
+// that hart a supervisor software interrupt through QEMU's ACLINT
+// SSWI device (make qemu passes aclint=on; kvmmake() maps it), so
+// the process doesn't wait for the hart's next timer interrupt.
+// Only the hart that clears a bit sends the IPI, so each wfi gets
+// at most one.
+#define SSIP (1L << 1)          // supervisor software interrupt, in sie and sip
+
+static int idlemask;     // harts waiting in wfi for work
+
+// Wake cpu if it is idle. Returns 1 if this call woke it.
+static int
+kick(int cpu)
+{
+  if((__sync_fetch_and_and(&idlemask, ~(1 << cpu)) & (1 << cpu)) == 0)
+    return 0;
+  *(volatile uint32*)ACLINT_SETSSIP(cpu) = 1;
+  return 1;
+}
+
+// p was just queued on its home CPU. Wake home if it is idle;
+// otherwise, if p has to wait there behind another process, wake
+// an idle hart p may run on, which then steals from the busiest
+// queue. A process that yields to an otherwise empty queue isn't
+// moved, its own hart picks it again straight away.
+// cpus[home].proc and nrunnable are read without locks; a stale
+// read only means a wasted or a missed IPI, and a missed one only
+// delays p until the next tick as before.
+static void
+wakeidle(struct proc *p)
+{
+  int home = p->home;
+
+  if(idlemask == 0 || kick(home))
+    return;
+  struct proc *running = cpus[home].proc;
+  if(runqs[home].nrunnable < 2 && (running == 0 || running == p))
+    return;
+  for(int i = 0; i < NCPU; i++){
+    if((idlemask & p->affinity & (1 << i)) && kick(i))
+      return;
+  }
+}
+
+// Mark p RUNNABLE and put it on its home CPU's run queue.
+// p->lock must be held.
+static void
+setrunnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  p->readytime = r_time();
+  tgroup_activate(p);
+  if(p->edf){
+    kick(p->edfcpu); // EDF processes aren't queued, see edf_pick()
+    return;
+  }
+  runq_insert(&runqs[p->home], p);
+  wakeidle(p);
+}
+
+// Task 2.2: CPU affinity. p->affinity is a mask of the CPUs p may
+// run on, all of them unless setaffinity() pinned it. p->home is
+// always kept inside the mask, so a process is only ever queued on
+// a CPU it may use, and only stealing has to check.
+#define ALLCPUS ((1 << NCPU) - 1)
+
+// harts that have entered scheduler(). make qemu starts CPUS of
+// the NCPU harts, and setaffinity() only accepts these.
+static int startedcpus;
+
+// Move p->home to the lowest CPU in p->affinity if it isn't in it.
+// p->lock must be held.
+static void
+affine(struct proc *p)
+{
+  if(p->affinity & (1 << p->home))
+    return;
+  for(int i = 0; i < NCPU; i++){
+    if(p->affinity & (1 << i)){
+      p->home = i;
+      return;
+    }
+  }
+}
+
+// Task 2.2: earliest-deadline-first class. A process that called
+// sched_setdeadline(runtime, period) gets runtime ticks of CPU in
+// every period of period ticks. Admission is per CPU: the process
+// is placed on one CPU whose EDF utilisation stays at most 1, and
+// only that CPU runs it. EDF processes are not on the run queues;
+// each CPU first runs its RUNNABLE EDF process with the earliest
+// deadline and budget left, and the lottery (or stride) draw
+// only gets the leftover time. A process that uses up its budget
+// is throttled until its next period starts.
+// Lock order: p->lock before edfq lock.
+#define EDF_UMAX 1000    // utilisation limit per CPU, per mille
+
+static struct edfq {
+  struct spinlock lock;
+  struct proc *head;     // EDF processes admitted on this CPU
+  int util;              // sum of their p->edf
+} edfqs[NCPU];
+
+// Return the RUNNABLE EDF process of CPU id with budget left and
+// the earliest deadline, or 0. Processes whose deadline has passed
+// start a new period first. p->state is read without p->lock, so
+// the caller checks it again.
+static struct proc*
+edf_pick(int id)
+{
+  struct edfq *eq = &edfqs[id];
+  struct proc *p, *best = 0;
+  uint64 now = r_time();
+
+  if(eq->head == 0)
+    return 0;
+  acquire(&eq->lock);
+  for(p = eq->head; p; p = p->edfnext){
+    if(now >= p->deadline){
+      p->deadline += ((now - p->deadline) / p->edfperiod + 1) * p->edfperiod;
+      p->budget = p->edfrun;
+    }
+    if(p->state == RUNNABLE && p->budget > 0 &&
+       (best == 0 || p->deadline < best->deadline))
+      best = p;
+  }
+  release(&eq->lock);
+  return best;
+}
+
+// Take cycles p just ran out of its budget.
+// p->lock must be held.
+static void
+edf_charge(struct proc *p, uint64 used)
+{
+  struct edfq *eq = &edfqs[p->edfcpu];
+
+  acquire(&eq->lock);
+  p->budget = used < p->budget ? p->budget - used : 0;
+  release(&eq->lock);
+}
+
+// Move p back to the normal class.
+// p->lock must be held.
+static void
+edf_leave(struct proc *p)
+{
+  struct edfq *eq = &edfqs[p->edfcpu];
+  struct proc **pp;
+
+  if(p->edf == 0)
+    return;
+  acquire(&eq->lock);
+  for(pp = &eq->head; *pp != p; pp = &(*pp)->edfnext)
+    ;
+  *pp = p->edfnext;
+  p->edfnext = 0;
+  eq->util -= p->edf;
+  p->edf = 0;
+  release(&eq->lock);
+}
+
+// Task 2.2: add one wakeup-to-run latency of the given time
+// CSR cycles (10 per microsecond) to p's histogram.
+static void
+latency(struct proc *p, uint64 cycles)
+{
+  uint64 us = cycles / (PSTAT_TICK / 100000);
+  int b = 0;
+
+  while(b < PSTAT_NLAT - 1 && us >= 2){
+    us >>= 1;
+    b++;
+  }
+  p->wakelat[b]++;
+}
+
+extern void forkret(void);
+static void freeproc(struct proc *p);
+
+extern char trampoline[]; // trampoline.S
+
+// helps ensure that wakeups of wait()ing
+// parents are not lost. helps obey the
+// memory model when using p->parent.
+// must be acquired before any p->lock.
+struct spinlock wait_lock;
+
+// Allocate a page for each process's kernel stack.
+// Map it high in memory, followed by an invalid
+// guard page.
+void
+proc_mapstacks(pagetable_t kpgtbl)
+{
+  struct proc *p;
+  
+  for(p = proc; p < &proc[NPROC]; p++) {
+    char *pa = kalloc();
+    if(pa == 0)
+      panic("kalloc");
+    uint64 va = KSTACK((int) (p - proc));
+    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
+  }
+}
+
+// initialize the proc table.
+void
+procinit(void)
+{
+  struct proc *p;
+  
+  initlock(&pid_lock, "nextpid");
+  initlock(&wait_lock, "wait_lock");
+  initlock(&tgroup_lock, "tgroup");
+  for(int i = 0; i < NCPU; i++){
+    initlock(&runqs[i].lock, "runq");
+    initlock(&edfqs[i].lock, "edfq");
+#ifndef SCHED_STRIDE
+    runqs[i].randstate = 88172645463393265ULL + i;
+#endif
+  }
+#ifndef SCHED_STRIDE
+  for(topbit = 1; topbit * 2 <= NPROC; topbit *= 2)
+    ;
+#endif
+  for(p = proc; p < &proc[NPROC]; p++) {
+      initlock(&p->lock, "proc");
+      p->state = UNUSED;
+      p->kstack = KSTACK((int) (p - proc));
+  }
+}
+
+// Must be called with interrupts disabled,
+// to prevent race with process being moved
+// to a different CPU.
+int
+cpuid()
+{
+  int id = r_tp();
+  return id;
+}
+
+// Return this CPU's cpu struct.
+// Interrupts must be disabled.
+struct cpu*
+mycpu(void)
+{
+  int id = cpuid();
+  struct cpu *c = &cpus[id];
+  return c;
+}
+
+// Return the current struct proc *, or zero if none.
+struct proc*
+myproc(void)
+{
+  push_off();
+  struct cpu *c = mycpu();
+  struct proc *p = c->proc;
+  pop_off();
+  return p;
+}
+
+int
+allocpid()
+{
+  int pid;
+  
+  acquire(&pid_lock);
+  pid = nextpid;
+  nextpid = nextpid + 1;
+  release(&pid_lock);
+
+  return pid;
+}
+
+// Look in the process table for an UNUSED proc.
+// If found, initialize state required to run in the kernel,
+// and return with p->lock held.
+// If there are no free procs, or a memory allocation fails, return 0.
+static struct proc*
+allocproc(void)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    acquire(&p->lock);
+    if(p->state == UNUSED) {
+      goto found;
+    } else {
+      release(&p->lock);
+    }
+  }
+  return 0;
+
+found:
+  p->pid = allocpid();
+  p->state = USED;
+
+  p->tickets = 10; // Task 2.2
+  p->pass = 0;      // joins its queue at the current vtime
+  p->comptickets = 0;
+  p->tgroup = 0;
+  p->gactive = 0;
+  p->home = cpuid(); // interrupts are off while p->lock is held
+  p->lastcpu = p->home;
+  p->affinity = ALLCPUS;
+  p->nsched = p->nvcsw = p->nivcsw = 0;
+  p->cputime = p->waittime = p->childtime = 0;
+  p->woken = 0;
+  memset(p->wakelat, 0, sizeof(p->wakelat));
+
+  // Allocate a trapframe page.
+  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // An empty user page table.
+  p->pagetable = proc_pagetable(p);
+  if(p->pagetable == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // Set up new context to start executing at forkret,
+  // which returns to user space.
+  memset(&p->context, 0, sizeof(p->context));
+  p->context.ra = (uint64)forkret;
+  p->context.sp = p->kstack + PGSIZE;
+
+  return p;
+}
+
+// free a proc structure and the data hanging from it,
+// including user pages.
+// p->lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  if(p->trapframe)
+    kfree((void*)p->trapframe);
+  p->trapframe = 0;
+  if(p->pagetable)
+    proc_freepagetable(p->pagetable, p->sz);
+  p->pagetable = 0;
+  p->sz = 0;
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->chan = 0;
+  p->killed = 0;
+  p->xstate = 0;
+  edf_leave(p); // no-op unless exit() was skipped
+  tgroup_leave(p);
+  p->state = UNUSED;
+}
+
+// Create a user page table for a given process, with no user memory,
+// but with trampoline and trapframe pages.
+pagetable_t
+proc_pagetable(struct proc *p)
+{
+  pagetable_t pagetable;
+
+  // An empty page table.
+  pagetable = uvmcreate();
+  if(pagetable == 0)
+    return 0;
+
+  // map the trampoline code (for system call return)
+  // at the highest user virtual address.
+  // only the supervisor uses it, on the way
+  // to/from user space, so not PTE_U.
+  if(mappages(pagetable, TRAMPOLINE, PGSIZE,
+              (uint64)trampoline, PTE_R | PTE_X) < 0){
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  // map the trapframe page just below the trampoline page, for
+  // trampoline.S.
+  if(mappages(pagetable, TRAPFRAME, PGSIZE,
+              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  return pagetable;
+}
+
+// Free a process's page table, and free the
+// physical memory it refers to.
+void
+proc_freepagetable(pagetable_t pagetable, uint64 sz)
+{
+  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+  uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  uvmfree(pagetable, sz);
+}
+
+// a user program that calls exec("/init")
+// assembled from ../user/initcode.S
+// od -t xC ../user/initcode
+uchar initcode[] = {
+  0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0x45, 0x02,
+  0x97, 0x05, 0x00, 0x00, 0x93, 0x85, 0x35, 0x02,
+  0x93, 0x08, 0x70, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0x93, 0x08, 0x20, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0xef, 0xf0, 0x9f, 0xff, 0x2f, 0x69, 0x6e, 0x69,
+  0x74, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+
+// Set up first user process.
+void
+userinit(void)
+{
+  struct proc *p;
+
+  p = allocproc();
+  initproc = p;
+  
+  // allocate one user page and copy initcode's instructions
+  // and data into it.
+  uvmfirst(p->pagetable, initcode, sizeof(initcode));
+  p->sz = PGSIZE;
+
+  // prepare for the very first "return" from kernel to user.
+  p->trapframe->epc = 0;      // user program counter
+  p->trapframe->sp = PGSIZE;  // user stack pointer
+
+  safestrcpy(p->name, "initcode", sizeof(p->name));
+  p->cwd = namei("/");
+
+  setrunnable(p);
+
+  release(&p->lock);
+}
+
+// Grow or shrink user memory by n bytes.
+// Return 0 on success, -1 on failure.
+int
+growproc(int n)
+{
+  uint64 sz;
+  struct proc *p = myproc();
+
+  sz = p->sz;
+  if(n > 0){
+    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
+      return -1;
+    }
+  } else if(n < 0){
+    sz = uvmdealloc(p->pagetable, sz, sz + n);
+  }
+  p->sz = sz;
+  return 0;
+}
+
+// Create a new process, copying the parent.
+// Sets up child kernel stack to return as if from fork() system call.
+int
+fork(void)
+{
+  int i, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  // Task 2.2
+  np->tickets = p->tickets;
+
+  // the child joins the parent's group and shares its budget.
+  if(p->tgroup){
+    acquire(&tgroup_lock);
+    tgroups[p->tgroup].nmembers++;
+    release(&tgroup_lock);
+    np->tgroup = p->tgroup;
+  }
+
+  // Copy user memory from parent to child.
+  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  np->sz = p->sz;
+
+  // copy saved user registers.
+  *(np->trapframe) = *(p->trapframe);
+
+  // Cause fork to return 0 in the child.
+  np->trapframe->a0 = 0;
+
+  // increment reference counts on open file descriptors.
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  // Task 2.2: the child inherits the parent's CPU affinity.
+  np->affinity = p->affinity;
+  affine(np);
+
+  pid = np->pid;
+
+  release(&np->lock);
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  setrunnable(np);
+  release(&np->lock);
+
+  return pid;
+}
+
+// Pass p's abandoned children to init.
+// Caller must hold wait_lock.
+void
+reparent(struct proc *p)
+{
+  struct proc *pp;
+
+  for(pp = proc; pp < &proc[NPROC]; pp++){
+    if(pp->parent == p){
+      pp->parent = initproc;
+      wakeup(initproc);
+    }
+  }
+}
+
+// Exit the current process.  Does not return.
+// An exited process remains in the zombie state
+// until its parent calls wait().
+void
+exit(int status)
+{
+  struct proc *p = myproc();
+
+  if(p == initproc)
+    panic("init exiting");
+
+  // Close all open files.
+  for(int fd = 0; fd < NOFILE; fd++){
+    if(p->ofile[fd]){
+      struct file *f = p->ofile[fd];
+      fileclose(f);
+      p->ofile[fd] = 0;
+    }
+  }
+
+  begin_op();
+  iput(p->cwd);
+  end_op();
+  p->cwd = 0;
+
+  acquire(&wait_lock);
+
+  // Give any children to init.
+  reparent(p);
+
+  // Parent might be sleeping in wait().
+  wakeup(p->parent);
+  
+  acquire(&p->lock);
+
+  p->xstate = status;
+  p->state = ZOMBIE;
+  tgroup_deactivate(p); // Task 2.2
+  // Task 2.2: a zombie won't run again, so its EDF reservation is
+  // free for admission now rather than once the parent waits.
+  edf_leave(p);
+
+  release(&wait_lock);
+
+  // Jump into the scheduler, never to return.
+  sched();
+  panic("zombie exit");
+}
+
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+int
+wait(uint64 addr)
+{
+  struct proc *pp;
+  int havekids, pid;
+  struct proc *p = myproc();
+
+  acquire(&wait_lock);
+
+  for(;;){
+    // Scan through table looking for exited children.
+    havekids = 0;
+    for(pp = proc; pp < &proc[NPROC]; pp++){
+      if(pp->parent == p){
+        // make sure the child isn't still in exit() or swtch().
+        acquire(&pp->lock);
+
+        havekids = 1;
+        if(pp->state == ZOMBIE){
+          // Found one.
+          pid = pp->pid;
+          p->childtime += pp->cputime + pp->childtime;
+          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
+                                  sizeof(pp->xstate)) < 0) {
+            release(&pp->lock);
+            release(&wait_lock);
+            return -1;
+          }
+          freeproc(pp);
+          release(&pp->lock);
+          release(&wait_lock);
+          return pid;
+        }
+        release(&pp->lock);
+      }
+    }
+
+    // No point waiting if we don't have any children.
+    if(!havekids || killed(p)){
+      release(&wait_lock);
+      return -1;
+    }
+    
+    // Wait for a child to exit.
+    sleep(p, &wait_lock);  //DOC: wait-sleep
+  }
+}
+
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+
+void
+scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+  int id = cpuid();
+  int idle = 0;
+
+  c->proc = 0;
+  __sync_fetch_and_or(&startedcpus, 1 << id); // Task 2.2
+  for(;;){
+    // The most recent process to run may have had interrupts
+    // turned off; enable them to avoid a deadlock if all
+    // processes are waiting. Then turn them back off
+    // to avoid a possible race between an interrupt
+    // and wfi.
+    intr_on();
+    intr_off();
+
+    int slot;
+    // Task 2.2: EDF processes admitted here come before the draw.
+    if((p = edf_pick(id)) != 0){
+      slot = p - proc;
+    } else {
+      slot = runq_draw(&runqs[id], -1);
+      if(slot < 0)
+        slot = runq_steal(id);
+    }
+    if(slot < 0 && !idle){
+      // Task 2.2: advertise this hart as idle, then look once
+      // more: a process queued before the bit was set is found
+      // by this second look, one queued after it gets a kick().
+      __sync_fetch_and_or(&idlemask, 1 << id);
+      idle = 1;
+      continue;
+    }
+    if(slot < 0){
+      // nothing to run; stop running on this core until an interrupt.
+      // wfi also returns for a pending SSIP while interrupts are off.
+      w_sie(r_sie() | SSIP);
+      asm volatile("wfi");
+      w_sie(r_sie() & ~SSIP);
+    }
+    if(idle){
+      // a kick() may still land after this; SSIP stays masked in
+      // sie outside wfi, so it only ends the next wfi early.
+      __sync_fetch_and_and(&idlemask, ~(1 << id));
+      w_sip(r_sip() & ~SSIP);
+      idle = 0;
+    }
+    if(slot < 0)
+      continue;
+
+    // only the winner's lock is taken. its slot left the tree in
+    // runq_draw(), so it is still RUNNABLE here.
+    p = &proc[slot];
+    acquire(&p->lock);
+    if(p->state == RUNNABLE && !p->edf && !(p->affinity & (1 << id))){
+      // Task 2.2: the local draw doesn't check affinity, so a
+      // process that setaffinity() pinned away while queued (or
+      // a stolen one whose affinity changed meanwhile) goes back
+      // to a CPU it may use.
+      affine(p);
+      setrunnable(p);
+    } else if(p->state == RUNNABLE){
+      p->home = id; // a stolen process stays on its new CPU
+      p->comptickets = 0; // compensation lasts until the next win
+      // the quantum ends at this hart's next timer interrupt. If
+      // that is already due, p gets no compensation for it.
+      p->runstart = r_time();
+      uint64 next = r_stimecmp();
+      p->slice = next > p->runstart ? next - p->runstart : 0;
+#ifdef SCHED_STRIDE
+      p->pass += STRIDE1 / basetickets(p);
+#endif
+      p->waittime += p->runstart - p->readytime;
+      if(p->woken){
+        p->woken = 0;
+        latency(p, p->runstart - p->readytime);
+      }
+      p->nsched++;
+      p->lastcpu = id;
+      p->state = RUNNING;
+      c->proc = p;
+      swtch(&c->context, &p->context);
+      c->proc = 0;
+      p->cputime += r_time() - p->runstart;
+      if(p->edf)
+        edf_charge(p, r_time() - p->runstart);
+    }
+    release(&p->lock);
+  }
+}
+
+// Switch to scheduler.  Must hold only p->lock
+// and have changed proc->state. Saves and restores
+// intena because intena is a property of this
+// kernel thread, not this CPU. It should
+// be proc->intena and proc->noff, but that would
+// break in the few places where a lock is held but
+// there's no process.
+void
+sched(void)
+{
+  int intena;
+  struct proc *p = myproc();
+
+  if(!holding(&p->lock))
+    panic("sched p->lock");
+  if(mycpu()->noff != 1)
+    panic("sched locks");
+  if(p->state == RUNNING)
+    panic("sched RUNNING");
+  if(intr_get())
+    panic("sched interruptible");
+
+  intena = mycpu()->intena;
+  swtch(&p->context, &mycpu()->context);
+  mycpu()->intena = intena;
+}
+
+// Give up the CPU for one scheduling round.
+void
+yield(void)
+{
+  struct proc *p = myproc();
+  acquire(&p->lock);
+  p->nivcsw++;
+  setrunnable(p);
+  sched();
+  release(&p->lock);
+}
+
+// A fork child's very first scheduling by scheduler()
+// will swtch to forkret.
+void
+forkret(void)
+{
+  static int first = 1;
+
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
+
+  if (first) {
+    // File system initialization must be run in the context of a
+    // regular process (e.g., because it calls sleep), and thus cannot
+    // be run from main().
+    fsinit(ROOTDEV);
+
+    first = 0;
+    // ensure other cores see first=0.
+    __sync_synchronize();
+  }
+
+  usertrapret();
+}
+
+// Sleep on wait channel chan, releasing condition lock lk.
+// Re-acquires lk when awakened.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  struct proc *p = myproc();
+  
+  // Must acquire p->lock in order to
+  // change p->state and then call sched.
+  // Once we hold p->lock, we can be
+  // guaranteed that we won't miss any wakeup
+  // (wakeup locks p->lock),
+  // so it's okay to release lk.
+
+  acquire(&p->lock);  //DOC: sleeplock1
+  release(lk);
+
+  // Task 2.2: compensation tickets. p is giving up the CPU after
+  // using only a fraction f = used/slice of its quantum, so it
+  // competes with tickets/f until it next wins.
+  uint64 used = r_time() - p->runstart;
+  if(used < p->slice){
+    int t = (p->tickets < 1) ? 1 : p->tickets;
+    if(used < p->slice / MAXCOMP)
+      used = p->slice / MAXCOMP;
+    uint64 c = used ? (uint64)t * p->slice / used : (uint64)t * MAXCOMP;
+    p->comptickets = (c > MAXTICKETS) ? MAXTICKETS : (int)c;
+  }
+
+  // Go to sleep.
+  p->chan = chan;
+  p->state = SLEEPING;
+  tgroup_deactivate(p);
+  p->nvcsw++;
+
+  sched();
+
+  // Tidy up.
+  p->chan = 0;
+
+  // Reacquire original lock.
+  release(&p->lock);
+  acquire(lk);
+}
+
+// Wake up all processes sleeping on wait channel chan.
+// Caller should hold the condition lock.
+void
+wakeup(void *chan)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    if(p != myproc()){
+      acquire(&p->lock);
+      if(p->state == SLEEPING && p->chan == chan) {
+        p->woken = 1;
+        setrunnable(p);
+      }
+      release(&p->lock);
+    }
+  }
+}
+
+// Kill the process with the given pid.
+// The victim won't exit until it tries to return
+// to user space (see usertrap() in trap.c).
+int
+kill(int pid)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid){
+      p->killed = 1;
+      if(p->state == SLEEPING){
+        // Wake process from sleep().
+        setrunnable(p);
+      }
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+void
+setkilled(struct proc *p)
+{
+  acquire(&p->lock);
+  p->killed = 1;
+  release(&p->lock);
+}
+
+int
+killed(struct proc *p)
+{
+  int k;
+  
+  acquire(&p->lock);
+  k = p->killed;
+  release(&p->lock);
+  return k;
+}
+
+// Copy to either a user address, or kernel address,
+// depending on usr_dst.
+// Returns 0 on success, -1 on error.
+int
+either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_dst){
+    return copyout(p->pagetable, dst, src, len);
+  } else {
+    memmove((char *)dst, src, len);
+    return 0;
+  }
+}
+
+// Copy from either a user address, or kernel address,
+// depending on usr_src.
+// Returns 0 on success, -1 on error.
+int
+either_copyin(void *dst, int user_src, uint64 src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_src){
+    return copyin(p->pagetable, dst, src, len);
+  } else {
+    memmove(dst, (char*)src, len);
+    return 0;
+  }
+}
+
+// Print a process listing to console.  For debugging.
+// Runs when user types ^P on console.
+// No lock to avoid wedging a stuck machine further.
+void
+procdump(void)
+{
+  static char *states[] = {
+  [UNUSED]    "unused",
+  [USED]      "used",
+  [SLEEPING]  "sleep ",
+  [RUNNABLE]  "runble",
+  [RUNNING]   "run   ",
+  [ZOMBIE]    "zombie"
+  };
+  struct proc *p;
+  char *state;
+
+  printf("\n");
+  for(p = proc; p < &proc[NPROC]; p++){
+    if(p->state == UNUSED)
+      continue;
+    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
+      state = states[p->state];
+    else
+      state = "???";
+    printf("%d %s %s", p->pid, state, p->name);
+    printf("\n");
+  }
+}
+
+// Task 2.2: copy p's scheduling statistics into st,
+// including the part of the current run or wait so far.
+// p->lock must be held.
+static void
+fillpstat(struct proc *p, struct pstat *st)
+{
+  st->pid = p->pid;
+  st->state = p->state;
+  safestrcpy(st->name, p->name, sizeof(st->name));
+  st->tickets = p->tickets;
+  st->lastcpu = p->lastcpu;
+  st->nsched = p->nsched;
+  st->nvcsw = p->nvcsw;
+  st->nivcsw = p->nivcsw;
+  st->cputime = p->cputime;
+  st->waittime = p->waittime;
+  memmove(st->wakelat, p->wakelat, sizeof(st->wakelat));
+  if(p->state == RUNNING)
+    st->cputime += r_time() - p->runstart;
+  else if(p->state == RUNNABLE)
+    st->waittime += r_time() - p->readytime;
+}
+
+// Copy the statistics of process pid to user address addr.
+// Returns 0, or -1 if there is no such process.
+int
+getprocstats(int pid, uint64 addr)
+{
+  struct proc *p;
+  struct pstat st;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      fillpstat(p, &st);
+      release(&p->lock);
+      return copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st));
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Copy the statistics of up to n processes to the user array
+// at addr. Returns how many were copied, or -1.
+int
+getallprocstats(uint64 addr, int n)
+{
+  struct proc *p;
+  struct pstat st;
+  int i = 0;
+
+  for(p = proc; p < &proc[NPROC] && i < n; p++){
+    acquire(&p->lock);
+    if(p->state == UNUSED){
+      release(&p->lock);
+      continue;
+    }
+    fillpstat(p, &st);
+    release(&p->lock);
+    if(copyout(myproc()->pagetable, addr + i * sizeof(st), (char *)&st, sizeof(st)) < 0)
+      return -1;
+    i++;
+  }
+  return i;
+}
+
+// Task 2.2: restrict process pid (0 for the caller) to the CPUs in
+// mask. CPUs that never started are dropped from mask. Returns 0,
+// or -1 if there is no such process or mask has no started CPU
+// in it.
+int
+setaffinity(int pid, int mask)
+{
+  struct proc *p;
+  struct proc *me = myproc();
+
+  mask &= startedcpus;
+  if(mask == 0)
+    return -1;
+  if(pid == 0)
+    pid = me->pid;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      p->affinity = mask;
+      // a queued process moves when its CPU next picks it.
+      if(p->state != RUNNABLE)
+        affine(p);
+      int away = !(mask & (1 << p->lastcpu));
+      release(&p->lock);
+      // leave this CPU now if it is no longer allowed.
+      if(p == me && away)
+        yield();
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Return the affinity mask of process pid (0 for the caller),
+// or -1 if there is no such process.
+int
+getaffinity(int pid)
+{
+  struct proc *p;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      int mask = p->affinity;
+      release(&p->lock);
+      return mask;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Task 2.2: put the caller in the EDF class with runtime ticks of CPU
+// every period ticks, or back in the normal class if runtime is 0.
+// Returns 0, or -1 if the arguments are bad or no CPU the caller may
+// run on has room for runtime/period more utilisation. An EDF
+// process stays on the CPU it was admitted on; setaffinity() only
+// takes effect once it leaves the class. Children are not EDF.
+int
+sched_setdeadline(int runtime, int period)
+{
+  struct proc *p = myproc();
+  int u, cpu = -1;
+
+  if(runtime < 0 || period <= 0 || runtime > period)
+    return -1;
+  u = ((uint64)runtime * EDF_UMAX + period - 1) / period;
+
+  acquire(&p->lock);
+  if(u > 0){
+    // reserve u on the first CPU with room, starting with this one,
+    // counting what p already holds there.
+    for(int k = 0; k < NCPU && cpu < 0; k++){
+      int i = (p->lastcpu + k) % NCPU;
+      struct edfq *eq = &edfqs[i];
+      if(!(p->affinity & (1 << i)))
+        continue;
+      acquire(&eq->lock);
+      int mine = (p->edf && p->edfcpu == i) ? p->edf : 0;
+      if(eq->util - mine + u <= EDF_UMAX){
+        eq->util += u;
+        cpu = i;
+      }
+      release(&eq->lock);
+    }
+    if(cpu < 0){
+      release(&p->lock);
+      return -1;
+    }
+  }
+
+  edf_leave(p);
+  if(u > 0){
+    struct edfq *eq = &edfqs[cpu];
+    acquire(&eq->lock);
+    p->edf = u;
+    p->edfcpu = cpu;
+    p->home = cpu;
+    p->edfrun = (uint64)runtime * TICK_CYCLES;
+    p->edfperiod = (uint64)period * TICK_CYCLES;
+    p->deadline = r_time() + p->edfperiod;
+    p->budget = p->edfrun;
+    p->edfnext = eq->head;
+    eq->head = p;
+    release(&eq->lock);
+  }
+  release(&p->lock);
+
+  // continue in the new class, on its CPU.
+  yield();
+  return 0;
+}
+
+// Task 2.2: set the caller's tickets, keeping its group's
+// active sum in step. Returns 0, or -1 if n < 1 or n > MAXTICKETS.
+int
+settickets(int n)
+{
+  struct proc *p = myproc();
+
+  if(n < 1 || n > MAXTICKETS)
+    return -1;
+  acquire(&p->lock);
+  p->tickets = n;
+  if(p->gactive){
+    tgroup_deactivate(p);
+    tgroup_activate(p);
+  }
+  release(&p->lock);
+  return 0;
+}
+
+// Task 2.2: put the caller in a new ticket group holding budget
+// base tickets. Its children join the group too, and nobody can
+// leave it, so only a process in the base currency may create one;
+// a tenant can't escape its budget by making another group.
+// Returns the group id, or -1.
+int
+tgroup(int budget)
+{
+  struct proc *p = myproc();
+  int gid = -1;
+
+  if(budget < 1)
+    return -1;
+  acquire(&p->lock);
+  if(p->tgroup == 0){
+    acquire(&tgroup_lock);
+    for(int i = 1; i < NTGROUP; i++){
+      if(tgroups[i].budget == 0){
+        tgroups[i].budget = budget;
+        tgroups[i].active = 0;
+        tgroups[i].nmembers = 1;
+        gid = i;
+        break;
+      }
+    }
+    release(&tgroup_lock);
+    if(gid > 0){
+      p->tgroup = gid;
+      tgroup_activate(p); // p is RUNNING
+    }
+  }
+  release(&p->lock);
+  return gid;
+}
+
+// Task 2.2: copy the caller's CPU usage (who is RUSAGE_SELF) or
+// that of the children it has waited for (RUSAGE_CHILDREN) to
+// user address addr. Returns 0, or -1.
+int
+getrusage(int who, uint64 addr)
+{
+  struct proc *p = myproc();
+  struct rusage ru;
+
+  memset(&ru, 0, sizeof(ru));
+  acquire(&p->lock);
+  if(who == RUSAGE_SELF){
+    ru.cputime = CYCLES_NS(p->cputime + (r_time() - p->runstart));
+    ru.waittime = CYCLES_NS(p->waittime);
+    ru.nvcsw = p->nvcsw;
+    ru.nivcsw = p->nivcsw;
+  } else if(who == RUSAGE_CHILDREN){
+    ru.cputime = CYCLES_NS(p->childtime);
+  } else {
+    release(&p->lock);
+    return -1;
+  }
+  release(&p->lock);
+  return copyout(p->pagetable, addr, (char *)&ru, sizeof(ru));
+}
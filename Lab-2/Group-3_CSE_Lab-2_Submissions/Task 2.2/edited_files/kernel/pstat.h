@@ -0,0 +1,44 @@
+// Task 2.2: per-process scheduling statistics,
+// returned by getprocstats() and getallprocstats().
+// Included by proc.h too, for PSTAT_NLAT.
+#ifndef PSTAT_H
+#define PSTAT_H
+
+// cputime and waittime are in time CSR cycles.
+// One clock tick (uptime()) is PSTAT_TICK cycles.
+#define PSTAT_TICK 1000000
+
+// wakelat[b] counts wakeups that waited [2^b, 2^(b+1))
+// microseconds before running; bucket 0 also holds < 1us and
+// the last bucket everything longer.
+#define PSTAT_NLAT 16
+
+struct pstat {
+  int pid;
+  int state;           // enum procstate in kernel/proc.h
+  char name[16];
+  int tickets;         // tickets set with settickets()
+  int lastcpu;         // CPU it last ran on
+  int nsched;          // times picked by the scheduler
+  int nvcsw;           // voluntary switches (blocked in sleep)
+  int nivcsw;          // involuntary switches (preempted)
+  uint64 cputime;      // cycles spent RUNNING
+  uint64 waittime;     // cycles spent RUNNABLE on a run queue
+  int wakelat[PSTAT_NLAT]; // wakeup-to-run latency histogram
+};
+
+// Task 2.2: getrusage(who, struct rusage *). Times are in nanoseconds;
+// the time CSR on QEMU's virt machine counts at 10 MHz, so they
+// are exact to 100ns.
+#define RUSAGE_SELF     0     // the caller
+#define RUSAGE_CHILDREN (-1)  // children the caller has waited for
+#define CYCLES_NS(c)    ((c) * 100)
+
+struct rusage {
+  uint64 cputime;      // ns spent RUNNING
+  uint64 waittime;     // ns spent RUNNABLE (RUSAGE_SELF only)
+  int nvcsw;           // voluntary switches (RUSAGE_SELF only)
+  int nivcsw;          // involuntary switches (RUSAGE_SELF only)
+};
+
+#endif
@@ -1,121 +1,209 @@
-#include "types.h"
-#include "riscv.h"
-#include "defs.h"
-#include "param.h"
-#include "memlayout.h"
-#include "spinlock.h"
-#include "proc.h"
-
-// Declare the process table
-extern struct proc proc[NPROC];
-
-uint64
-sys_exit(void)
-{
-  int n;
-  argint(0, &n);
-  exit(n);
-  return 0;  // not reached
-}
-
-uint64
-sys_getpid(void)
-{
-  return myproc()->pid;
-}
-
-uint64
-sys_fork(void)
-{
-  return fork();
-}
-
-uint64
-sys_wait(void)
-{
-  uint64 p;
-  argaddr(0, &p);
-  return wait(p);
-}
-
-uint64
-sys_sbrk(void)
-{
-  uint64 addr;
-  int n;
-
-  argint(0, &n);
-  addr = myproc()->sz;
-  if(growproc(n) < 0)
-    return -1;
-  return addr;
-}
-
-uint64
-sys_sleep(void)
-{
-  int n;
-  uint ticks0;
-
-  argint(0, &n);
-  if(n < 0)
-    n = 0;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
-}
-
-uint64
-sys_kill(void)
-{
-  int pid;
-
-  argint(0, &pid);
-  return kill(pid);
-}
-
-// return how many clock tick interrupts have occurred
-// since start.
-uint64
-sys_uptime(void)
-{
-  uint xticks;
-
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
-}
-
-// Task 2.2
-extern uint64 sys_gettickets(void);
-extern uint64 sys_settickets(void);
-
-uint64
-sys_settickets(void) 
-{
-  int n;
-  argint(0, &n);
-  if(n < 1) return -1;
-
-  struct proc *p = myproc();
-  acquire(&p->lock);
-  p->tickets = n;
-  release(&p->lock);
-  return 0;
-}
-
-uint64
-sys_gettickets(void)
-{
-  struct proc* p = myproc();
-  return (uint64)p->tickets;
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "proc.h"
+
+// Declare the process table
+extern struct proc proc[NPROC];
+
+uint64
+sys_exit(void)
+{
+  int n;
+  argint(0, &n);
+  exit(n);
+  return 0;  // not reached
+}
+
+uint64
+sys_getpid(void)
+{
+  return myproc()->pid;
+}
+
+uint64
+sys_fork(void)
+{
+  return fork();
+}
+
+uint64
+sys_wait(void)
+{
+  uint64 p;
+  argaddr(0, &p);
+  return wait(p);
+}
+
+uint64
+sys_sbrk(void)
+{
+  uint64 addr;
+  int n;
+
+  argint(0, &n);
+  addr = myproc()->sz;
+  if(growproc(n) < 0)
+    return -1;
+  return addr;
+}
+
+uint64
+sys_sleep(void)
+{
+  int n;
+  uint ticks0;
+
+  argint(0, &n);
+  if(n < 0)
+    n = 0;
+  acquire(&tickslock);
+  ticks0 = ticks;
+  while(ticks - ticks0 < n){
+    if(killed(myproc())){
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&ticks, &tickslock);
+  }
+  release(&tickslock);
+  return 0;
+}
+
+uint64
+sys_kill(void)
+{
+  int pid;
+
+  argint(0, &pid);
+  return kill(pid);
+}
+
+// return how many clock tick interrupts have occurred
+// since start.
+uint64
+sys_uptime(void)
+{
+  uint xticks;
+
+  acquire(&tickslock);
+  xticks = ticks;
+  release(&tickslock);
+  return xticks;
+}
+
+// Task 2.2
+extern uint64 sys_gettickets(void);
+extern uint64 sys_settickets(void);
+
+extern int settickets(int);
+
+uint64
+sys_settickets(void) 
+{
+  int n;
+  argint(0, &n);
+  return settickets(n);
+}
+
+uint64
+sys_gettickets(void)
+{
+  struct proc* p = myproc();
+  return (uint64)p->tickets;
+}
+
+// getprocstats(pid, struct pstat *)
+extern int getprocstats(int, uint64);
+extern int getallprocstats(uint64, int);
+
+uint64
+sys_getprocstats(void)
+{
+  int pid;
+  uint64 addr;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return getprocstats(pid, addr);
+}
+
+// getallprocstats(struct pstat *, n): returns the number filled in
+uint64
+sys_getallprocstats(void)
+{
+  uint64 addr;
+  int n;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  if(n < 0)
+    return -1;
+  return getallprocstats(addr, n);
+}
+
+
+// setaffinity(pid, mask): bit i of mask allows CPU i
+extern int setaffinity(int, int);
+extern int getaffinity(int);
+
+uint64
+sys_setaffinity(void)
+{
+  int pid, mask;
+
+  argint(0, &pid);
+  argint(1, &mask);
+  return setaffinity(pid, mask);
+}
+
+uint64
+sys_getaffinity(void)
+{
+  int pid;
+
+  argint(0, &pid);
+  return getaffinity(pid);
+}
+
+// sched_setdeadline(runtime, period), both in ticks
+extern int sched_setdeadline(int, int);
+
+uint64
+sys_sched_setdeadline(void)
+{
+  int runtime, period;
+
+  argint(0, &runtime);
+  argint(1, &period);
+  return sched_setdeadline(runtime, period);
+}
+
+// tgroup(budget): move into a new ticket group
+extern int tgroup(int);
+
+uint64
+sys_tgroup(void)
+{
+  int budget;
+
+  argint(0, &budget);
+  return tgroup(budget);
+}
+
+// getrusage(who, struct rusage *)
+extern int getrusage(int, uint64);
+
+uint64
+sys_getrusage(void)
+{
+  int who;
+  uint64 addr;
+
+  argint(0, &who);
+  argaddr(1, &addr);
+  return getrusage(who, addr);
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+// Task 2.2: scheduler fairness and throughput benchmark.
+//
+// usage: schedbench [-c ncpu] [-w w1,w2,...] [-i nio] [-p npairs] [-t ticks]
+//   -c  CPU-bound children (default 3)
+//   -w  their tickets, used in turn (default 10 each)
+//   -i  I/O-bound children that sleep a tick and do a little work
+//   -p  pairs of children that ping-pong a byte over two pipes
+//   -t  measurement window in clock ticks (default 100, about 10s)
+//
+// The shares are taken from the kernel's own accounting
+// (getprocstats) at the start and end of the window. Output is
+// one "key=value" line per child plus a summary line; shares and
+// Jain's index are in per mille.
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+#define MAXKIDS 32
+
+#if defined(SCHED_STRIDE)
+#define POLICY "stride"
+#else
+#define POLICY "lottery"
+#endif
+#define setweight(w) settickets(w)
+
+enum { CPU, IO, PING, PONG };
+static char *kinds[] = { "cpu", "io", "ping", "pong" };
+
+static int pids[MAXKIDS], kind[MAXKIDS], weight[MAXKIDS];
+static struct pstat start[MAXKIDS], end[MAXKIDS];
+static int nkids;
+
+static void
+spin(int n)
+{
+  for(volatile int i = 0; i < n; i++)
+    ;
+}
+
+// fork a child of the given kind that runs until the parent
+// kills it.
+static void
+spawn(int k, int w, int rfd, int wfd)
+{
+  char c = 0;
+
+  if(nkids == MAXKIDS){
+    fprintf(2, "schedbench: too many children\n");
+    exit(1);
+  }
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "schedbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    if(w > 0 && setweight(w) < 0)
+      fprintf(2, "schedbench: cannot set weight %d\n", w);
+    for(;;){
+      if(k == CPU){
+        spin(100000);
+      } else if(k == IO){
+        sleep(1);
+        spin(1000);
+      } else {
+        // ping writes first, pong answers
+        if(k == PING && write(wfd, &c, 1) != 1)
+          exit(1);
+        if(read(rfd, &c, 1) != 1)
+          exit(1);
+        if(k == PONG && write(wfd, &c, 1) != 1)
+          exit(1);
+      }
+    }
+  }
+  pids[nkids] = pid;
+  kind[nkids] = k;
+  weight[nkids] = w;
+  nkids++;
+}
+
+// one ping-pong pair, one pipe each way.
+static void
+spawnpair(void)
+{
+  int ab[2], ba[2];
+
+  if(pipe(ab) < 0 || pipe(ba) < 0){
+    fprintf(2, "schedbench: pipe failed\n");
+    exit(1);
+  }
+  spawn(PING, 0, ba[0], ab[1]);
+  spawn(PONG, 0, ab[0], ba[1]);
+  close(ab[0]); close(ab[1]);
+  close(ba[0]); close(ba[1]);
+}
+
+static void
+snapshot(struct pstat *st)
+{
+  for(int i = 0; i < nkids; i++){
+    if(getprocstats(pids[i], &st[i]) < 0){
+      fprintf(2, "schedbench: getprocstats %d failed\n", pids[i]);
+      exit(1);
+    }
+  }
+}
+
+// parse "10,20,30" into w[], returns the count.
+static int
+parseweights(char *s, int *w, int max)
+{
+  int n = 0;
+
+  while(*s && n < max){
+    w[n++] = atoi(s);
+    while(*s && *s != ',')
+      s++;
+    if(*s == ',')
+      s++;
+  }
+  return n;
+}
+
+// latency at percentile pct, as the upper edge of its bucket in us.
+static int
+percentile(int *hist, int total, int pct)
+{
+  int want = (total * pct + 99) / 100, seen = 0;
+
+  for(int b = 0; b < PSTAT_NLAT; b++){
+    seen += hist[b];
+    if(seen >= want && hist[b])
+      return 1 << (b + 1);
+  }
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ncpu = 3, nio = 0, npairs = 0, dur = 100;
+  int w[MAXKIDS], nw = 0;
+
+  for(int i = 1; i + 1 < argc; i += 2){
+    if(strcmp(argv[i], "-c") == 0)
+      ncpu = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-w") == 0)
+      nw = parseweights(argv[i+1], w, MAXKIDS);
+    else if(strcmp(argv[i], "-i") == 0)
+      nio = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-p") == 0)
+      npairs = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-t") == 0)
+      dur = atoi(argv[i+1]);
+    else {
+      fprintf(2, "usage: schedbench [-c ncpu] [-w w1,w2,...] [-i nio] [-p npairs] [-t ticks]\n");
+      exit(1);
+    }
+  }
+  if(dur < 1)
+    dur = 1;
+
+  for(int i = 0; i < ncpu; i++)
+    spawn(CPU, nw ? w[i % nw] : 10, -1, -1);
+  for(int i = 0; i < nio; i++)
+    spawn(IO, 0, -1, -1);
+  for(int i = 0; i < npairs; i++)
+    spawnpair();
+
+  sleep(2); // let every child set its weight
+  snapshot(start);
+  int t0 = uptime();
+  sleep(dur);
+  snapshot(end);
+  int t1 = uptime();
+  for(int i = 0; i < nkids; i++)
+    kill(pids[i]);
+  for(int i = 0; i < nkids; i++)
+    wait(0);
+
+  // CPU-bound children: achieved vs. expected share
+  uint64 cpusum = 0, wsum = 0;
+  for(int i = 0; i < nkids; i++){
+    if(kind[i] == CPU){
+      cpusum += end[i].cputime - start[i].cputime;
+      wsum += weight[i];
+    }
+  }
+  if(cpusum == 0)
+    cpusum = 1;
+  if(wsum == 0)
+    wsum = 1;
+
+  uint64 xsum = 0, x2sum = 0;
+  int n = 0, switches = 0, harts = 0, hist[PSTAT_NLAT], nlat = 0;
+  memset(hist, 0, sizeof(hist));
+  for(int i = 0; i < nkids; i++){
+    uint64 cpu = end[i].cputime - start[i].cputime;
+    int share = 0, expected = 0;
+    int sw = (end[i].nvcsw - start[i].nvcsw) + (end[i].nivcsw - start[i].nivcsw);
+
+    if(kind[i] == CPU){
+      share = cpu * 1000 / cpusum;
+      expected = weight[i] * 1000 / wsum;
+      // normalized throughput for Jain's index
+      uint64 x = expected ? (uint64)share * 1000 / expected : 0;
+      xsum += x;
+      x2sum += x * x;
+      n++;
+    }
+    switches += sw;
+    if(end[i].lastcpu + 1 > harts)
+      harts = end[i].lastcpu + 1;
+    for(int b = 0; b < PSTAT_NLAT; b++){
+      int d = end[i].wakelat[b] - start[i].wakelat[b];
+      hist[b] += d;
+      nlat += d;
+    }
+    printf("child pid=%d kind=%s weight=%d cpu_ms=%d share=%d expected=%d runs=%d switches=%d\n",
+           pids[i], kinds[kind[i]], weight[i],
+           (int)(cpu / (PSTAT_TICK / 100)), share, expected,
+           end[i].nsched - start[i].nsched, sw);
+  }
+
+  int ticks = t1 - t0 > 0 ? t1 - t0 : 1;
+  int jain = (n && x2sum) ? (int)(xsum * xsum * 1000 / (n * x2sum)) : 1000;
+  int maxlat = 0;
+  for(int b = 0; b < PSTAT_NLAT; b++)
+    if(hist[b])
+      maxlat = 1 << (b + 1);
+  printf("summary policy=%s harts=%d ticks=%d cpu=%d io=%d pairs=%d jain=%d cswps=%d wakeups=%d lat_p50_us=%d lat_p99_us=%d lat_max_us=%d\n",
+         POLICY, harts, ticks, ncpu, nio, npairs, jain,
+         switches * 10 / ticks, nlat,
+         percentile(hist, nlat, 50), percentile(hist, nlat, 99), maxlat);
+  exit(0);
+}
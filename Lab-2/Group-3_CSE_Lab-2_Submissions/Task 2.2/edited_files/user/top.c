@@ -0,0 +1,62 @@
+// Task 2.2: top-style monitor built on getallprocstats().
+// usage: top [rounds]   (refreshes once a second, forever by default)
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+static char *states[] = { "unused", "used", "sleep", "runble", "run", "zombie" };
+
+// two snapshots, so each refresh can show usage over the last second
+static struct pstat cur[NPROC], prev[NPROC];
+static int ncur, nprev;
+
+// CPU cycles p used since the previous snapshot
+static uint64
+delta(struct pstat *p)
+{
+  for(int i = 0; i < nprev; i++)
+    if(prev[i].pid == p->pid)
+      return p->cputime - prev[i].cputime;
+  return p->cputime;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 0;
+  int last = uptime();
+
+  for(int r = 0; rounds == 0 || r < rounds; r++){
+    sleep(10); // 10 ticks is about one second
+    ncur = getallprocstats(cur, NPROC);
+    if(ncur < 0){
+      fprintf(2, "top: getallprocstats failed\n");
+      exit(1);
+    }
+    int now = uptime();
+    uint64 span = (uint64)(now - last) * PSTAT_TICK;
+    if(span == 0)
+      span = 1;
+    last = now;
+
+    printf("\033[2J\033[H"); // clear the screen
+    printf("PID\tSTATE\tCPU\tTICKETS\t%%CPU\tRUNS\tVCSW\tIVCSW\tCPUms\tWAITms\tNAME\n");
+    for(int i = 0; i < ncur; i++){
+      struct pstat *p = &cur[i];
+      char *st = (p->state >= 0 && p->state < sizeof(states)/sizeof(states[0])) ? states[p->state] : "???";
+      printf("%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s\n",
+             p->pid, st, p->lastcpu, p->tickets,
+             (int)(delta(p) * 100 / span),
+             p->nsched, p->nvcsw, p->nivcsw,
+             (int)(p->cputime / (PSTAT_TICK / 100)),
+             (int)(p->waittime / (PSTAT_TICK / 100)),
+             p->name);
+    }
+
+    memmove(prev, cur, sizeof(cur));
+    nprev = ncur;
+  }
+  exit(0);
+}
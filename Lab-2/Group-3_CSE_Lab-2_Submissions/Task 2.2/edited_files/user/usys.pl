@@ -39,4 +39,11 @@ entry("uptime");
 
 # Task 2.2
 entry("settickets");
-entry("gettickets");
\ No newline at end of file
+entry("gettickets");
+entry("getprocstats");
+entry("getallprocstats");
+entry("setaffinity");
+entry("getaffinity");
+entry("sched_setdeadline");
+entry("tgroup");
+entry("getrusage");
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Task 3.1: spinlock statistics, returned by lockstats().
+// Locks are counted by the name given to initlock(), so e.g. all
+// "proc" locks share one entry. Times are in time CSR cycles.
+#define NLOCKSTAT 64      // lock names tracked
+
+struct lockstat {
+  char name[16];       // initlock() name
+  uint64 acquires;     // acquire() calls
+  uint64 contended;    // ... that found the lock held
+  uint64 spincycles;   // time spent waiting for it
+  uint64 maxhold;      // longest time it was held, 0 unless built with LOCKHOLD
+};
@@ -1,137 +1,186 @@
-#include "types.h"
-#include "param.h"
-#include "memlayout.h"
-#include "spinlock.h"
-#include "riscv.h"
-#include "proc.h"
-#include "mbox.h"
-#include "defs.h"
-
-static struct {
-  struct mailbox box[MAX_MBOX];
-} mboxes; // table of mbox
-
-void
-mboxinit(void)
-{
-  for (int i = 0; i < MAX_MBOX; i++) {
-    initlock(&mboxes.box[i].lock, "mbox");
-    mboxes.box[i].used = 0;
-    mboxes.box[i].key = 0;
-    mboxes.box[i].head = mboxes.box[i].tail = mboxes.box[i].count = 0;
-    mboxes.box[i].closed = 0;
-  }
-}
-
-static int // if mboxes.box[i].key == key then it returns i
-find_id_by_key(int key)
-{
-  for (int i = 0; i < MAX_MBOX; i++)
-    if (mboxes.box[i].used && mboxes.box[i].key == key)
-      return i;
-  return -1;
-}
-
-int
-mbox_create(int key)
-{
-  int id = find_id_by_key(key);
-  if (id >= 0) return id;
-
-  for (int i = 0; i < MAX_MBOX; i++) {
-    if (!mboxes.box[i].used) {
-      mboxes.box[i].used = 1;
-      mboxes.box[i].key = key;
-
-      acquire(&mboxes.box[i].lock);
-      mboxes.box[i].head = mboxes.box[i].tail = mboxes.box[i].count = 0;
-      mboxes.box[i].closed = 0;
-      release(&mboxes.box[i].lock);
-      return i;
-    }
-  }
-  return -1;
-}
-
-int
-mbox_send(int id, int msg)
-{
-  if (id < 0 || id >= MAX_MBOX) return -1;
-
-  struct mailbox *b = &mboxes.box[id];
-  acquire(&b->lock);
-
-  if (!b->used || b->closed) {
-    release(&b->lock);
-    return -1;
-  }
-
-  while (b->count == MBOX_CAP && !b->closed) {
-    sleep(b, &b->lock);
-  } // busy waiting
-
-  if (b->closed) {
-    release(&b->lock);
-    return -1;
-  }
-
-  b->buf[b->tail] = msg;
-  b->tail = (b->tail + 1) % MBOX_CAP;
-  b->count++;
-  wakeup(b);
-
-  release(&b->lock);
-  return 0;
-}
-
-int
-mbox_recv(int id, int *msg)
-{
-  if (id < 0 || id >= MAX_MBOX) return -1;
-
-  struct mailbox *b = &mboxes.box[id];
-  acquire(&b->lock);
-
-  if (!b->used) {
-    release(&b->lock);
-    return -1;
-  }
-  
-  while (b->count == 0 && !b->closed) {
-    sleep(b, &b->lock);
-  }
-
-  if (b->count == 0 && b->closed) { // end of the mailbox entries
-    release(&b->lock);
-    return -1;
-  }
-
-  int v = b->buf[b->head];
-  b->head = (b->head + 1) % MBOX_CAP;
-  b->count--;
-  wakeup(b);
-  release(&b->lock);
-
-  *msg = v;
-  return 0;
-}
-
-int 
-mbox_close(int id)
-{
-  if (id < 0 || id >= MAX_MBOX) return -1;
-
-  struct mailbox *b = &mboxes.box[id];
-  acquire(&b->lock);
-
-  if (!b->used) {
-    release(&b->lock);
-    return -1;
-  } 
-
-  b->closed = 1;
-  wakeup(b);
-
-  release(&b->lock);
-  return 0;
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "proc.h"
+#include "mbox.h"
+#include "defs.h"
+
+static struct {
+  struct mailbox box[MAX_MBOX];
+} mboxes; // table of mbox
+
+void
+mboxinit(void)
+{
+  for (int i = 0; i < MAX_MBOX; i++) {
+    initlock(&mboxes.box[i].lock, "mbox");
+    mboxes.box[i].used = 0;
+    mboxes.box[i].key = 0;
+    mboxes.box[i].head = mboxes.box[i].tail = mboxes.box[i].count = 0;
+    mboxes.box[i].closed = 0;
+    mboxes.box[i].server = 0;
+    mboxes.box[i].waiter = 0;
+    mboxes.box[i].nwaiting = 0;
+  }
+}
+
+static int // if mboxes.box[i].key == key then it returns i
+find_id_by_key(int key)
+{
+  for (int i = 0; i < MAX_MBOX; i++)
+    if (mboxes.box[i].used && mboxes.box[i].key == key)
+      return i;
+  return -1;
+}
+
+int
+mbox_create(int key)
+{
+  int id = find_id_by_key(key);
+  if (id >= 0) return id;
+
+  for (int i = 0; i < MAX_MBOX; i++) {
+    if (!mboxes.box[i].used) {
+      mboxes.box[i].used = 1;
+      mboxes.box[i].key = key;
+
+      acquire(&mboxes.box[i].lock);
+      mboxes.box[i].head = mboxes.box[i].tail = mboxes.box[i].count = 0;
+      mboxes.box[i].closed = 0;
+      mboxes.box[i].server = myproc()->pid; // creator sends until rebound
+      mboxes.box[i].waiter = 0;
+      mboxes.box[i].nwaiting = 0;
+      release(&mboxes.box[i].lock);
+      return i;
+    }
+  }
+  return -1;
+}
+
+int
+mbox_send(int id, int msg)
+{
+  if (id < 0 || id >= MAX_MBOX) return -1;
+
+  struct mailbox *b = &mboxes.box[id];
+  acquire(&b->lock);
+
+  if (!b->used || b->closed) {
+    release(&b->lock);
+    return -1;
+  }
+
+  while (b->count == MBOX_CAP && !b->closed) {
+    sleep(b, &b->lock);
+  } // busy waiting
+
+  if (b->closed) {
+    release(&b->lock);
+    return -1;
+  }
+
+  b->buf[b->tail] = msg;
+  b->tail = (b->tail + 1) % MBOX_CAP;
+  b->count++;
+  wakeup(b);
+
+  // a receiver was asleep waiting for this message: switch to it
+  // directly instead of going through the scheduler.
+  int to = b->waiter;
+  b->waiter = 0;
+  release(&b->lock);
+  if (to && to != myproc()->pid)
+    yield_to(to);
+  return 0;
+}
+
+int
+mbox_recv(int id, int *msg)
+{
+  if (id < 0 || id >= MAX_MBOX) return -1;
+
+  struct mailbox *b = &mboxes.box[id];
+  acquire(&b->lock);
+
+  if (!b->used) {
+    release(&b->lock);
+    return -1;
+  }
+  
+  // while we wait, lend our turn to the process that will send,
+  // so it isn't left behind unrelated processes (priority inversion).
+  int lender = 0;
+  while (b->count == 0 && !b->closed) {
+    if (lender == 0 && b->server && b->server != myproc()->pid)
+      if (sched_lend(b->server) == 0)
+        lender = b->server;
+    // mbox_send() hands off to us only while we are the one
+    // receiver asleep; with more, it can't tell which one gets
+    // the message, so it just wakes them.
+    b->nwaiting++;
+    b->waiter = (b->nwaiting == 1) ? myproc()->pid : 0;
+    sleep(b, &b->lock);
+    b->nwaiting--;
+  }
+  if (b->waiter == myproc()->pid)
+    b->waiter = 0; // don't leave a stale pid for the next send
+  if (lender)
+    sched_unlend(lender); // the message (or EOF) is here
+
+  if (b->count == 0 && b->closed) { // end of the mailbox entries
+    release(&b->lock);
+    return -1;
+  }
+
+  int v = b->buf[b->head];
+  b->head = (b->head + 1) % MBOX_CAP;
+  b->count--;
+  wakeup(b);
+  release(&b->lock);
+
+  *msg = v;
+  return 0;
+}
+
+int 
+mbox_close(int id)
+{
+  if (id < 0 || id >= MAX_MBOX) return -1;
+
+  struct mailbox *b = &mboxes.box[id];
+  acquire(&b->lock);
+
+  if (!b->used) {
+    release(&b->lock);
+    return -1;
+  } 
+
+  b->closed = 1;
+  wakeup(b);
+
+  release(&b->lock);
+  return 0;
+}
+
+// make the calling process the sender that blocked receivers
+// lend their turn to.
+int
+mbox_bind_server(int id)
+{
+  if (id < 0 || id >= MAX_MBOX) return -1;
+
+  struct mailbox *b = &mboxes.box[id];
+  acquire(&b->lock);
+
+  if (!b->used) {
+    release(&b->lock);
+    return -1;
+  }
+
+  b->server = myproc()->pid;
+
+  release(&b->lock);
+  return 0;
 }
\ No newline at end of file
@@ -1,17 +1,21 @@
-#define MAX_MBOX   64
-#define MBOX_CAP   16
-
-struct mailbox {
-  struct spinlock lock;
-  int used;
-  int key;
-  int buf[MBOX_CAP];
-  int head, tail, count;
-  int closed; // to make sure that the mailbox is closed properly
-};
-
-void mboxinit(void);
-int  mbox_create(int key);
-int  mbox_send(int id, int msg);
-int  mbox_recv(int id, int *msg);
-int  mbox_close(int id);
\ No newline at end of file
+#define MAX_MBOX   64
+#define MBOX_CAP   16
+
+struct mailbox {
+  struct spinlock lock;
+  int used;
+  int key;
+  int buf[MBOX_CAP];
+  int head, tail, count;
+  int closed; // to make sure that the mailbox is closed properly
+  int server; // pid expected to send on this mailbox, 0 if none
+  int waiter; // pid of the only receiver asleep in mbox_recv, or 0
+  int nwaiting; // receivers asleep in mbox_recv
+};
+
+void mboxinit(void);
+int  mbox_create(int key);
+int  mbox_send(int id, int msg);
+int  mbox_recv(int id, int *msg);
+int  mbox_close(int id);
+int  mbox_bind_server(int id);
\ No newline at end of file
@@ -1,690 +1,1368 @@
-#include "types.h"
-#include "param.h"
-#include "memlayout.h"
-#include "riscv.h"
-#include "spinlock.h"
-#include "proc.h"
-#include "defs.h"
-
-struct cpu cpus[NCPU];
-
-struct proc proc[NPROC];
-
-struct proc *initproc;
-
-int nextpid = 1;
-struct spinlock pid_lock;
-
-extern void forkret(void);
-static void freeproc(struct proc *p);
-
-extern char trampoline[]; // trampoline.S
-
-// helps ensure that wakeups of wait()ing
-// parents are not lost. helps obey the
-// memory model when using p->parent.
-// must be acquired before any p->lock.
-struct spinlock wait_lock;
-
-// Allocate a page for each process's kernel stack.
-// Map it high in memory, followed by an invalid
-// guard page.
-void
-proc_mapstacks(pagetable_t kpgtbl)
-{
-  struct proc *p;
-  
-  for(p = proc; p < &proc[NPROC]; p++) {
-    char *pa = kalloc();
-    if(pa == 0)
-      panic("kalloc");
-    uint64 va = KSTACK((int) (p - proc));
-    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
-  }
-}
-
-// initialize the proc table.
-void
-procinit(void)
-{
-  struct proc *p;
-  
-  initlock(&pid_lock, "nextpid");
-  initlock(&wait_lock, "wait_lock");
-  for(p = proc; p < &proc[NPROC]; p++) {
-      initlock(&p->lock, "proc");
-      p->state = UNUSED;
-      p->kstack = KSTACK((int) (p - proc));
-  }
-}
-
-// Must be called with interrupts disabled,
-// to prevent race with process being moved
-// to a different CPU.
-int
-cpuid()
-{
-  int id = r_tp();
-  return id;
-}
-
-// Return this CPU's cpu struct.
-// Interrupts must be disabled.
-struct cpu*
-mycpu(void)
-{
-  int id = cpuid();
-  struct cpu *c = &cpus[id];
-  return c;
-}
-
-// Return the current struct proc *, or zero if none.
-struct proc*
-myproc(void)
-{
-  push_off();
-  struct cpu *c = mycpu();
-  struct proc *p = c->proc;
-  pop_off();
-  return p;
-}
-
-int
-allocpid()
-{
-  int pid;
-  
-  acquire(&pid_lock);
-  pid = nextpid;
-  nextpid = nextpid + 1;
-  release(&pid_lock);
-
-  return pid;
-}
-
-// Look in the process table for an UNUSED proc.
-// If found, initialize state required to run in the kernel,
-// and return with p->lock held.
-// If there are no free procs, or a memory allocation fails, return 0.
-static struct proc*
-allocproc(void)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->state == UNUSED) {
-      goto found;
-    } else {
-      release(&p->lock);
-    }
-  }
-  return 0;
-
-found:
-  p->pid = allocpid();
-  p->state = USED;
-
-  // Allocate a trapframe page.
-  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // An empty user page table.
-  p->pagetable = proc_pagetable(p);
-  if(p->pagetable == 0){
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
-  // Set up new context to start executing at forkret,
-  // which returns to user space.
-  memset(&p->context, 0, sizeof(p->context));
-  p->context.ra = (uint64)forkret;
-  p->context.sp = p->kstack + PGSIZE;
-
-  return p;
-}
-
-// free a proc structure and the data hanging from it,
-// including user pages.
-// p->lock must be held.
-static void
-freeproc(struct proc *p)
-{
-  if(p->trapframe)
-    kfree((void*)p->trapframe);
-  p->trapframe = 0;
-  if(p->pagetable) {
-    // Task 3.1
-    shm_cleanup(p);
-    proc_freepagetable(p->pagetable, p->sz);
-  }
-  p->pagetable = 0;
-  p->sz = 0;
-  p->pid = 0;
-  p->parent = 0;
-  p->name[0] = 0;
-  p->chan = 0;
-  p->killed = 0;
-  p->xstate = 0;
-  p->state = UNUSED;
-}
-
-// Create a user page table for a given process, with no user memory,
-// but with trampoline and trapframe pages.
-pagetable_t
-proc_pagetable(struct proc *p)
-{
-  pagetable_t pagetable;
-
-  // An empty page table.
-  pagetable = uvmcreate();
-  if(pagetable == 0)
-    return 0;
-
-  // map the trampoline code (for system call return)
-  // at the highest user virtual address.
-  // only the supervisor uses it, on the way
-  // to/from user space, so not PTE_U.
-  if(mappages(pagetable, TRAMPOLINE, PGSIZE,
-              (uint64)trampoline, PTE_R | PTE_X) < 0){
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  // map the trapframe page just below the trampoline page, for
-  // trampoline.S.
-  if(mappages(pagetable, TRAPFRAME, PGSIZE,
-              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
-    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-    uvmfree(pagetable, 0);
-    return 0;
-  }
-
-  return pagetable;
-}
-
-// Free a process's page table, and free the
-// physical memory it refers to.
-void
-proc_freepagetable(pagetable_t pagetable, uint64 sz)
-{
-  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-  uvmunmap(pagetable, TRAPFRAME, 1, 0);
-  uvmfree(pagetable, sz);
-}
-
-// Set up first user process.
-void
-userinit(void)
-{
-  struct proc *p;
-
-  p = allocproc();
-  initproc = p;
-  
-  p->cwd = namei("/");
-
-  p->state = RUNNABLE;
-
-  release(&p->lock);
-}
-
-// Shrink user memory by n bytes.
-// Return 0 on success, -1 on failure.
-int
-growproc(int n)
-{
-  uint64 sz;
-  struct proc *p = myproc();
-
-  sz = p->sz;
-  if(n > 0){
-    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
-      return -1;
-    }
-  } else if(n < 0){
-    sz = uvmdealloc(p->pagetable, sz, sz + n);
-  }
-  p->sz = sz;
-  return 0;
-}
-
-// Create a new process, copying the parent.
-// Sets up child kernel stack to return as if from fork() system call.
-int
-kfork(void)
-{
-  int i, pid;
-  struct proc *np;
-  struct proc *p = myproc();
-
-  // Allocate process.
-  if((np = allocproc()) == 0){
-    return -1;
-  }
-
-  // Copy user memory from parent to child.
-  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
-    freeproc(np);
-    release(&np->lock);
-    return -1;
-  }
-  np->sz = p->sz;
-
-  // copy saved user registers.
-  *(np->trapframe) = *(p->trapframe);
-
-  // Cause fork to return 0 in the child.
-  np->trapframe->a0 = 0;
-
-  // increment reference counts on open file descriptors.
-  for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);
-  np->cwd = idup(p->cwd);
-
-  safestrcpy(np->name, p->name, sizeof(p->name));
-
-  pid = np->pid;
-
-  release(&np->lock);
-
-  acquire(&wait_lock);
-  np->parent = p;
-  release(&wait_lock);
-
-  acquire(&np->lock);
-  np->state = RUNNABLE;
-  release(&np->lock);
-
-  return pid;
-}
-
-// Pass p's abandoned children to init.
-// Caller must hold wait_lock.
-void
-reparent(struct proc *p)
-{
-  struct proc *pp;
-
-  for(pp = proc; pp < &proc[NPROC]; pp++){
-    if(pp->parent == p){
-      pp->parent = initproc;
-      wakeup(initproc);
-    }
-  }
-}
-
-// Exit the current process.  Does not return.
-// An exited process remains in the zombie state
-// until its parent calls wait().
-void
-kexit(int status)
-{
-  struct proc *p = myproc();
-
-  if(p == initproc)
-    panic("init exiting");
-
-  // Close all open files.
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);
-      p->ofile[fd] = 0;
-    }
-  }
-
-  begin_op();
-  iput(p->cwd);
-  end_op();
-  p->cwd = 0;
-
-  acquire(&wait_lock);
-
-  // Give any children to init.
-  reparent(p);
-
-  // Parent might be sleeping in wait().
-  wakeup(p->parent);
-  
-  acquire(&p->lock);
-
-  p->xstate = status;
-  p->state = ZOMBIE;
-
-  release(&wait_lock);
-
-  // Jump into the scheduler, never to return.
-  sched();
-  panic("zombie exit");
-}
-
-// Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
-int
-kwait(uint64 addr)
-{
-  struct proc *pp;
-  int havekids, pid;
-  struct proc *p = myproc();
-
-  acquire(&wait_lock);
-
-  for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){
-        // make sure the child isn't still in exit() or swtch().
-        acquire(&pp->lock);
-
-        havekids = 1;
-        if(pp->state == ZOMBIE){
-          // Found one.
-          pid = pp->pid;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
-                                  sizeof(pp->xstate)) < 0) {
-            release(&pp->lock);
-            release(&wait_lock);
-            return -1;
-          }
-          freeproc(pp);
-          release(&pp->lock);
-          release(&wait_lock);
-          return pid;
-        }
-        release(&pp->lock);
-      }
-    }
-
-    // No point waiting if we don't have any children.
-    if(!havekids || killed(p)){
-      release(&wait_lock);
-      return -1;
-    }
-    
-    // Wait for a child to exit.
-    sleep(p, &wait_lock);  //DOC: wait-sleep
-  }
-}
-
-// Per-CPU process scheduler.
-// Each CPU calls scheduler() after setting itself up.
-// Scheduler never returns.  It loops, doing:
-//  - choose a process to run.
-//  - swtch to start running that process.
-//  - eventually that process transfers control
-//    via swtch back to the scheduler.
-void
-scheduler(void)
-{
-  struct proc *p;
-  struct cpu *c = mycpu();
-
-  c->proc = 0;
-  for(;;){
-    // The most recent process to run may have had interrupts
-    // turned off; enable them to avoid a deadlock if all
-    // processes are waiting. Then turn them back off
-    // to avoid a possible race between an interrupt
-    // and wfi.
-    intr_on();
-    intr_off();
-
-    int found = 0;
-    for(p = proc; p < &proc[NPROC]; p++) {
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        // Switch to chosen process.  It is the process's job
-        // to release its lock and then reacquire it
-        // before jumping back to us.
-        p->state = RUNNING;
-        c->proc = p;
-        swtch(&c->context, &p->context);
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-        found = 1;
-      }
-      release(&p->lock);
-    }
-    if(found == 0) {
-      // nothing to run; stop running on this core until an interrupt.
-      asm volatile("wfi");
-    }
-  }
-}
-
-// Switch to scheduler.  Must hold only p->lock
-// and have changed proc->state. Saves and restores
-// intena because intena is a property of this
-// kernel thread, not this CPU. It should
-// be proc->intena and proc->noff, but that would
-// break in the few places where a lock is held but
-// there's no process.
-void
-sched(void)
-{
-  int intena;
-  struct proc *p = myproc();
-
-  if(!holding(&p->lock))
-    panic("sched p->lock");
-  if(mycpu()->noff != 1)
-    panic("sched locks");
-  if(p->state == RUNNING)
-    panic("sched RUNNING");
-  if(intr_get())
-    panic("sched interruptible");
-
-  intena = mycpu()->intena;
-  swtch(&p->context, &mycpu()->context);
-  mycpu()->intena = intena;
-}
-
-// Give up the CPU for one scheduling round.
-void
-yield(void)
-{
-  struct proc *p = myproc();
-  acquire(&p->lock);
-  p->state = RUNNABLE;
-  sched();
-  release(&p->lock);
-}
-
-// A fork child's very first scheduling by scheduler()
-// will swtch to forkret.
-void
-forkret(void)
-{
-  extern char userret[];
-  static int first = 1;
-  struct proc *p = myproc();
-
-  // Still holding p->lock from scheduler.
-  release(&p->lock);
-
-  if (first) {
-    // File system initialization must be run in the context of a
-    // regular process (e.g., because it calls sleep), and thus cannot
-    // be run from main().
-    fsinit(ROOTDEV);
-
-    first = 0;
-    // ensure other cores see first=0.
-    __sync_synchronize();
-
-    // We can invoke kexec() now that file system is initialized.
-    // Put the return value (argc) of kexec into a0.
-    p->trapframe->a0 = kexec("/init", (char *[]){ "/init", 0 });
-    if (p->trapframe->a0 == -1) {
-      panic("exec");
-    }
-  }
-
-  // return to user space, mimicing usertrap()'s return.
-  prepare_return();
-  uint64 satp = MAKE_SATP(p->pagetable);
-  uint64 trampoline_userret = TRAMPOLINE + (userret - trampoline);
-  ((void (*)(uint64))trampoline_userret)(satp);
-}
-
-// Sleep on channel chan, releasing condition lock lk.
-// Re-acquires lk when awakened.
-void
-sleep(void *chan, struct spinlock *lk)
-{
-  struct proc *p = myproc();
-  
-  // Must acquire p->lock in order to
-  // change p->state and then call sched.
-  // Once we hold p->lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
-  // so it's okay to release lk.
-
-  acquire(&p->lock);  //DOC: sleeplock1
-  release(lk);
-
-  // Go to sleep.
-  p->chan = chan;
-  p->state = SLEEPING;
-
-  sched();
-
-  // Tidy up.
-  p->chan = 0;
-
-  // Reacquire original lock.
-  release(&p->lock);
-  acquire(lk);
-}
-
-// Wake up all processes sleeping on channel chan.
-// Caller should hold the condition lock.
-void
-wakeup(void *chan)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
-      acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-    }
-  }
-}
-
-// Kill the process with the given pid.
-// The victim won't exit until it tries to return
-// to user space (see usertrap() in trap.c).
-int
-kkill(int pid)
-{
-  struct proc *p;
-
-  for(p = proc; p < &proc[NPROC]; p++){
-    acquire(&p->lock);
-    if(p->pid == pid){
-      p->killed = 1;
-      if(p->state == SLEEPING){
-        // Wake process from sleep().
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-      return 0;
-    }
-    release(&p->lock);
-  }
-  return -1;
-}
-
-void
-setkilled(struct proc *p)
-{
-  acquire(&p->lock);
-  p->killed = 1;
-  release(&p->lock);
-}
-
-int
-killed(struct proc *p)
-{
-  int k;
-  
-  acquire(&p->lock);
-  k = p->killed;
-  release(&p->lock);
-  return k;
-}
-
-// Copy to either a user address, or kernel address,
-// depending on usr_dst.
-// Returns 0 on success, -1 on error.
-int
-either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_dst){
-    return copyout(p->pagetable, dst, src, len);
-  } else {
-    memmove((char *)dst, src, len);
-    return 0;
-  }
-}
-
-// Copy from either a user address, or kernel address,
-// depending on usr_src.
-// Returns 0 on success, -1 on error.
-int
-either_copyin(void *dst, int user_src, uint64 src, uint64 len)
-{
-  struct proc *p = myproc();
-  if(user_src){
-    return copyin(p->pagetable, dst, src, len);
-  } else {
-    memmove(dst, (char*)src, len);
-    return 0;
-  }
-}
-
-// Print a process listing to console.  For debugging.
-// Runs when user types ^P on console.
-// No lock to avoid wedging a stuck machine further.
-void
-procdump(void)
-{
-  static char *states[] = {
-  [UNUSED]    "unused",
-  [USED]      "used",
-  [SLEEPING]  "sleep ",
-  [RUNNABLE]  "runble",
-  [RUNNING]   "run   ",
-  [ZOMBIE]    "zombie"
-  };
-  struct proc *p;
-  char *state;
-
-  printf("\n");
-  for(p = proc; p < &proc[NPROC]; p++){
-    if(p->state == UNUSED)
-      continue;
-    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
-      state = states[p->state];
-    else
-      state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
-    printf("\n");
-  }
-}
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "wait.h"
+
+struct cpu cpus[NCPU];
+
+// Task 3.1: there is no fixed proc[NPROC] table. procgrow() allocates
+// struct procs a page at a time when the free list runs dry, and
+// links them on allproc for the scheduler. They are never freed;
+// only their kernel stacks and trapframes are.
+struct proc *allproc;
+
+struct proc *initproc;
+
+int nextpid = 1;
+struct spinlock pid_lock;
+
+// Task 3.1: UNUSED procs are kept on a free list, so allocproc()
+// doesn't search allproc. Lock order: p->lock, then freeprocs.lock.
+static struct {
+  struct spinlock lock;
+  struct proc *head;
+} freeprocs;
+
+// Task 3.1: live procs hashed by pid, so kkill() and friends
+// don't search allproc. p->pid doesn't change while p is on a chain.
+// Lock order: p->lock, then the bucket lock.
+#define NPIDHASH 64
+
+static struct pidhash {
+  struct spinlock lock;
+  struct proc *head;
+} pidhash[NPIDHASH];
+
+// Task 3.1: each CPU takes pids from pid_lock PIDBATCH at a time.
+#define PIDBATCH 32
+
+static struct {
+  int next;
+  int end;
+} pidbatch[NCPU];
+
+// Task 3.1: kernel stack and trapframe pages freed by freeproc()
+// are kept in a small per-CPU cache for the next allocproc().
+#define PGCACHE 8
+
+static struct {
+  int n;
+  void *pg[PGCACHE];
+} pgcache[NCPU];
+
+// Task 3.1: freeproc() keeps up to PTCACHE emptied user page tables
+// per CPU, with the trampoline still mapped, for proc_pagetable().
+#define PTCACHE 4
+
+static struct {
+  int n;
+  pagetable_t pt[PTCACHE];
+} ptcache[NCPU];
+
+// Task 3.1: processes in a gang are also linked on ganglist, so
+// gangpick() only looks at them instead of all of allproc, and
+// nothing at all when no gang is set. Lock order: gang_lock, then
+// p->lock. p->gang only changes with both held.
+static struct spinlock gang_lock;
+static struct proc *ganglist;
+
+extern void forkret(void);
+static void freeproc(struct proc *p);
+static pagetable_t ptget(void);
+static void ptput(pagetable_t, uint64);
+static void handoff_done(void);
+static void gang_set(struct proc *, int);
+static void *pgalloc(void);
+static void pgfree(void *);
+
+extern char trampoline[]; // trampoline.S
+
+// Task 3.1: sleepers are kept on a hash table of wait queues keyed
+// by channel, so wakeup() only looks at processes that may be
+// sleeping on its channel instead of taking every p->lock.
+// Lock order: sleep()'s condition lock, then the bucket lock,
+// then p->lock.
+#define NSLEEPQ_BITS 6
+#define NSLEEPQ (1 << NSLEEPQ_BITS)
+
+static struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+} sleepqs[NSLEEPQ];
+
+static struct sleepq*
+sleepq(void *chan)
+{
+  // Fibonacci hashing: the high bits of chan * 2^64/phi.
+  return &sleepqs[((uint64)chan * 0x9E3779B97F4A7C15ULL) >> (64 - NSLEEPQ_BITS)];
+}
+
+// Task 3.1: instead of one global wait_lock, each process has a
+// kidlock protecting its children and zombies lists and the
+// parent field of its children. It helps ensure that wakeups of
+// wait()ing parents are not lost, and must be acquired before
+// any p->lock. The only nesting of two kidlocks is an exiting
+// process's own followed by initproc's, in reparent().
+
+// put child c on list *l (its parent's children or zombies).
+static void
+kid_link(struct proc **l, struct proc *c)
+{
+  c->sibling = *l;
+  if(c->sibling)
+    c->sibling->psibling = &c->sibling;
+  *l = c;
+  c->psibling = l;
+}
+
+static void
+kid_unlink(struct proc *c)
+{
+  *c->psibling = c->sibling;
+  if(c->sibling)
+    c->sibling->psibling = c->psibling;
+  c->sibling = 0;
+  c->psibling = 0;
+}
+
+// move every process on list *from to the front of list *to,
+// making them children of parent.
+static void
+kid_splice(struct proc **to, struct proc **from, struct proc *parent)
+{
+  struct proc *c, *last = 0;
+
+  for(c = *from; c; c = c->sibling){
+    c->parent = parent;
+    last = c;
+  }
+  if(last == 0)
+    return;
+  last->sibling = *to;
+  if(*to)
+    (*to)->psibling = &last->sibling;
+  *to = *from;
+  (*to)->psibling = to;
+  *from = 0;
+}
+
+// Lock the kidlock of p's parent and return the parent. p->parent
+// may change (reparent()) until that lock is held, so check again.
+static struct proc*
+lockparent(struct proc *p)
+{
+  struct proc *pp;
+
+  for(;;){
+    pp = p->parent;
+    acquire(&pp->kidlock);
+    if(p->parent == pp)
+      return pp;
+    release(&pp->kidlock);
+  }
+}
+
+// Task 3.1: kernel stacks are no longer mapped at boot. procgrow()
+// gives each struct proc a slot, allocproc() maps a page at
+// KSTACK(slot) in the kernel page table and freeproc() unmaps it.
+// The page below each slot stays unmapped as a guard page.
+extern pagetable_t kernel_pagetable; // vm.c
+
+static struct spinlock kstack_lock;  // kernel page table updates
+static int nkslots;                  // slots handed out, under freeprocs.lock
+
+// Bumped on every stack map and unmap. A CPU that has seen an
+// older value may have stale kernel TLB entries for the stacks,
+// so kstack_sync() flushes before it switches to a process.
+static uint kstackgen;
+
+void
+proc_mapstacks(pagetable_t kpgtbl)
+{
+}
+
+// Map a fresh kernel stack page at KSTACK(p->kslot).
+// Return -1 if out of memory.
+static int
+kstack_map(struct proc *p)
+{
+  uint64 va = KSTACK(p->kslot);
+  void *pa;
+
+  if((pa = pgalloc()) == 0)
+    return -1;
+  acquire(&kstack_lock);
+  if(mappages(kernel_pagetable, va, PGSIZE, (uint64)pa, PTE_R | PTE_W) < 0){
+    release(&kstack_lock);
+    pgfree(pa);
+    return -1;
+  }
+  __sync_fetch_and_add(&kstackgen, 1);
+  release(&kstack_lock);
+  p->kstack = va;
+  return 0;
+}
+
+static void
+kstack_unmap(struct proc *p)
+{
+  void *pa;
+
+  acquire(&kstack_lock);
+  pa = (void*)PTE2PA(*walk(kernel_pagetable, p->kstack, 0));
+  uvmunmap(kernel_pagetable, p->kstack, 1, 0);
+  __sync_fetch_and_add(&kstackgen, 1);
+  release(&kstack_lock);
+  sfence_vma();
+  pgfree(pa);
+}
+
+// Flush this CPU's TLB if kernel stacks were mapped or unmapped
+// since it last did. Called before switching to a process, whose
+// stack may be new or may reuse a slot. Interrupts must be off.
+static void
+kstack_sync(struct cpu *c)
+{
+  uint gen = kstackgen;
+
+  if(c->kstackgen != gen){
+    c->kstackgen = gen;
+    sfence_vma();
+  }
+}
+
+// initialize the proc table.
+void
+procinit(void)
+{
+  initticketlock(&pid_lock, "nextpid");
+  initticketlock(&freeprocs.lock, "freeprocs");
+  initlock(&kstack_lock, "kstack");
+  initlock(&gang_lock, "gang");
+  for(int i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepqs[i].lock, "sleepq");
+  for(int i = 0; i < NPIDHASH; i++)
+    initlock(&pidhash[i].lock, "pidhash");
+}
+
+// Task 3.1: add a page of UNUSED procs to allproc and the free list.
+// Return -1 if out of memory.
+_Static_assert(sizeof(struct proc) <= PGSIZE, "struct proc must fit in a page");
+
+static int
+procgrow(void)
+{
+  struct proc *np, *p;
+  int n = PGSIZE / sizeof(struct proc);
+
+  if((np = (struct proc *)kalloc()) == 0)
+    return -1;
+  memset(np, 0, PGSIZE);
+  for(p = np; p < &np[n]; p++){
+    initlock(&p->lock, "proc");
+    initlock(&p->kidlock, "kids");
+    p->state = UNUSED;
+    p->allnext = p + 1;
+    p->nextfree = p + 1;
+  }
+
+  acquire(&freeprocs.lock);
+  for(p = np; p < &np[n]; p++)
+    p->kslot = nkslots++;
+  np[n-1].allnext = allproc;
+  np[n-1].nextfree = freeprocs.head;
+  // scheduler() walks allproc without a lock.
+  __sync_synchronize();
+  allproc = np;
+  freeprocs.head = np;
+  release(&freeprocs.lock);
+  return 0;
+}
+
+// Task 3.1: allocate a page for a kernel stack or trapframe,
+// from this CPU's cache if it has one.
+static void*
+pgalloc(void)
+{
+  void *pa = 0;
+
+  push_off();
+  int id = cpuid();
+  if(pgcache[id].n > 0)
+    pa = pgcache[id].pg[--pgcache[id].n];
+  pop_off();
+  if(pa == 0)
+    pa = kalloc();
+  return pa;
+}
+
+static void
+pgfree(void *pa)
+{
+  push_off();
+  int id = cpuid();
+  if(pgcache[id].n < PGCACHE){
+    pgcache[id].pg[pgcache[id].n++] = pa;
+    pa = 0;
+  }
+  pop_off();
+  if(pa)
+    kfree(pa);
+}
+
+// Must be called with interrupts disabled,
+// to prevent race with process being moved
+// to a different CPU.
+int
+cpuid()
+{
+  int id = r_tp();
+  return id;
+}
+
+// Return this CPU's cpu struct.
+// Interrupts must be disabled.
+struct cpu*
+mycpu(void)
+{
+  int id = cpuid();
+  struct cpu *c = &cpus[id];
+  return c;
+}
+
+// Return the current struct proc *, or zero if none.
+struct proc*
+myproc(void)
+{
+  push_off();
+  struct cpu *c = mycpu();
+  struct proc *p = c->proc;
+  pop_off();
+  return p;
+}
+
+// Task 3.1: take the next pid from this CPU's batch, refilling
+// the batch from nextpid only once every PIDBATCH forks.
+int
+allocpid()
+{
+  int pid;
+  
+  push_off();
+  int id = cpuid();
+  if(pidbatch[id].next == pidbatch[id].end){
+    acquire(&pid_lock);
+    pidbatch[id].next = nextpid;
+    nextpid = nextpid + PIDBATCH;
+    release(&pid_lock);
+    pidbatch[id].end = pidbatch[id].next + PIDBATCH;
+  }
+  pid = pidbatch[id].next++;
+  pop_off();
+
+  return pid;
+}
+
+static struct pidhash*
+pidbucket(int pid)
+{
+  return &pidhash[(uint)pid % NPIDHASH];
+}
+
+// Task 3.1: find the live process with the given pid.
+// Returns it with p->lock held, or 0 if there is none.
+static struct proc*
+findproc(int pid)
+{
+  struct pidhash *b = pidbucket(pid);
+  struct proc *p;
+
+  acquire(&b->lock);
+  for(p = b->head; p; p = p->pidnext)
+    if(p->pid == pid)
+      break;
+  release(&b->lock);
+  if(p == 0)
+    return 0;
+
+  // pids aren't reused, so if p still has this pid
+  // it is still the process we found.
+  acquire(&p->lock);
+  if(p->pid != pid){
+    release(&p->lock);
+    return 0;
+  }
+  return p;
+}
+
+// Take an UNUSED proc off the free list.
+// If found, initialize state required to run in the kernel,
+// and return with p->lock held.
+// If there are no free procs, or a memory allocation fails, return 0.
+static struct proc*
+allocproc(void)
+{
+  struct proc *p;
+
+  for(;;){
+    acquire(&freeprocs.lock);
+    p = freeprocs.head;
+    if(p)
+      freeprocs.head = p->nextfree;
+    release(&freeprocs.lock);
+    if(p)
+      break;
+    if(procgrow() < 0)
+      return 0;
+  }
+
+  acquire(&p->lock);
+  p->nextfree = 0;
+  p->pid = allocpid();
+  p->state = USED;
+
+  struct pidhash *b = pidbucket(p->pid);
+  acquire(&b->lock);
+  p->pidnext = b->head;
+  b->head = p;
+  release(&b->lock);
+
+  // Allocate and map a kernel stack page.
+  if(kstack_map(p) < 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // Allocate a trapframe page.
+  if((p->trapframe = (struct trapframe *)pgalloc()) == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // An empty user page table.
+  p->pagetable = proc_pagetable(p);
+  if(p->pagetable == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  // Set up new context to start executing at forkret,
+  // which returns to user space.
+  memset(&p->context, 0, sizeof(p->context));
+  p->context.ra = (uint64)forkret;
+  p->context.sp = p->kstack + PGSIZE;
+
+  return p;
+}
+
+// free a proc structure and the data hanging from it,
+// including user pages.
+// p->lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  if(p->trapframe)
+    pgfree((void*)p->trapframe);
+  p->trapframe = 0;
+  // nothing runs on the stack any more: the process was ZOMBIE
+  // and we hold p->lock, or it never ran.
+  if(p->kstack)
+    kstack_unmap(p);
+  p->kstack = 0;
+  if(p->pagetable) {
+    // Task 3.1
+    shm_cleanup(p);
+    ptput(p->pagetable, p->sz);
+  }
+  p->pagetable = 0;
+  p->sz = 0;
+  if(p->pid){
+    // Task 3.1: off the pid hash before the pid changes.
+    struct pidhash *b = pidbucket(p->pid);
+    struct proc **pp;
+    acquire(&b->lock);
+    for(pp = &b->head; *pp != p; pp = &(*pp)->pidnext)
+      ;
+    *pp = p->pidnext;
+    p->pidnext = 0;
+    release(&b->lock);
+  }
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->chan = 0;
+  p->killed = 0;
+  p->xstate = 0;
+  p->loans = 0;
+  p->gang = 0;
+  p->wakepend = 0;
+  p->state = UNUSED;
+
+  // Task 3.1: back on the free list. allocproc() may take it at
+  // once, but waits for p->lock before using it.
+  acquire(&freeprocs.lock);
+  p->nextfree = freeprocs.head;
+  freeprocs.head = p;
+  release(&freeprocs.lock);
+}
+
+// Create a user page table for a given process, with no user memory,
+// but with trampoline and trapframe pages.
+pagetable_t
+proc_pagetable(struct proc *p)
+{
+  pagetable_t pagetable;
+
+  // Task 3.1: reuse a page table freeproc() left in the cache.
+  if((pagetable = ptget()) == 0){
+    // An empty page table.
+    pagetable = uvmcreate();
+    if(pagetable == 0)
+      return 0;
+
+    // map the trampoline code (for system call return)
+    // at the highest user virtual address.
+    // only the supervisor uses it, on the way
+    // to/from user space, so not PTE_U.
+    if(mappages(pagetable, TRAMPOLINE, PGSIZE,
+                (uint64)trampoline, PTE_R | PTE_X) < 0){
+      uvmfree(pagetable, 0);
+      return 0;
+    }
+  }
+
+  // map the trapframe page just below the trampoline page, for
+  // trampoline.S.
+  if(mappages(pagetable, TRAPFRAME, PGSIZE,
+              (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  return pagetable;
+}
+
+// Free a process's page table, and free the
+// physical memory it refers to.
+void
+proc_freepagetable(pagetable_t pagetable, uint64 sz)
+{
+  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+  uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  uvmfree(pagetable, sz);
+}
+
+// Task 3.1: take an empty page table with the trampoline
+// mapped from this CPU's cache, or return 0.
+static pagetable_t
+ptget(void)
+{
+  pagetable_t pagetable = 0;
+
+  push_off();
+  int id = cpuid();
+  if(ptcache[id].n > 0)
+    pagetable = ptcache[id].pt[--ptcache[id].n];
+  pop_off();
+  return pagetable;
+}
+
+// Task 3.1: like proc_freepagetable(), but keep the page table,
+// emptied of user memory and the trapframe, in this CPU's cache
+// if there is room. Its page-table pages stay allocated, so the
+// next proc_pagetable() and uvmalloc() into it don't kalloc() them.
+static void
+ptput(pagetable_t pagetable, uint64 sz)
+{
+  uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  if(sz > 0)
+    uvmunmap(pagetable, 0, PGROUNDUP(sz)/PGSIZE, 1);
+
+  push_off();
+  int id = cpuid();
+  if(ptcache[id].n < PTCACHE){
+    ptcache[id].pt[ptcache[id].n++] = pagetable;
+    pagetable = 0;
+  }
+  pop_off();
+
+  if(pagetable){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+  }
+}
+
+// Set up first user process.
+void
+userinit(void)
+{
+  struct proc *p;
+
+  p = allocproc();
+  initproc = p;
+  
+  p->cwd = namei("/");
+
+  p->state = RUNNABLE;
+
+  release(&p->lock);
+}
+
+// Shrink user memory by n bytes.
+// Return 0 on success, -1 on failure.
+int
+growproc(int n)
+{
+  uint64 sz;
+  struct proc *p = myproc();
+
+  sz = p->sz;
+  if(n > 0){
+    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
+      return -1;
+    }
+  } else if(n < 0){
+    sz = uvmdealloc(p->pagetable, sz, sz + n);
+  }
+  p->sz = sz;
+  return 0;
+}
+
+// Create a new process, copying the parent.
+// Sets up child kernel stack to return as if from fork() system call.
+int
+kfork(void)
+{
+  int i, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  // Copy user memory from parent to child.
+  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  np->sz = p->sz;
+
+  // copy saved user registers.
+  *(np->trapframe) = *(p->trapframe);
+
+  // Cause fork to return 0 in the child.
+  np->trapframe->a0 = 0;
+
+  // increment reference counts on open file descriptors.
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  pid = np->pid;
+
+  release(&np->lock);
+
+  // Task 3.1: children stay in the parent's gang.
+  gang_set(np, p->gang);
+
+  acquire(&p->kidlock);
+  np->parent = p;
+  kid_link(&p->children, np);
+  release(&p->kidlock);
+
+  acquire(&np->lock);
+  np->state = RUNNABLE;
+  release(&np->lock);
+
+  return pid;
+}
+
+// Pass p's abandoned children to init.
+// Task 3.1: takes p's kidlock and then initproc's.
+void
+reparent(struct proc *p)
+{
+  acquire(&p->kidlock);
+  if(p->children || p->zombies){
+    acquire(&initproc->kidlock);
+    kid_splice(&initproc->children, &p->children, initproc);
+    if(p->zombies){
+      kid_splice(&initproc->zombies, &p->zombies, initproc);
+      wakeup(initproc);
+    }
+    release(&initproc->kidlock);
+  }
+  release(&p->kidlock);
+}
+
+// Exit the current process.  Does not return.
+// An exited process remains in the zombie state
+// until its parent calls wait().
+void
+kexit(int status)
+{
+  struct proc *p = myproc();
+
+  if(p == initproc)
+    panic("init exiting");
+
+  // Close all open files.
+  for(int fd = 0; fd < NOFILE; fd++){
+    if(p->ofile[fd]){
+      struct file *f = p->ofile[fd];
+      fileclose(f);
+      p->ofile[fd] = 0;
+    }
+  }
+
+  begin_op();
+  iput(p->cwd);
+  end_op();
+  p->cwd = 0;
+
+  // Give any children to init.
+  reparent(p);
+
+  // Task 3.1: off ganglist.
+  if(p->gang)
+    gang_set(p, 0);
+
+  // Task 3.1: move to the parent's zombies list.
+  struct proc *pp = lockparent(p);
+  kid_unlink(p);
+  kid_link(&pp->zombies, p);
+
+  // Parent might be sleeping in wait().
+  wakeup(pp);
+  
+  acquire(&p->lock);
+
+  p->xstate = status;
+  p->state = ZOMBIE;
+
+  release(&pp->kidlock);
+
+  // Jump into the scheduler, never to return.
+  sched();
+  panic("zombie exit");
+}
+
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+int
+kwait(uint64 addr)
+{
+  return waitpid(-1, addr, 0);
+}
+
+// Task 3.1: wait for the child with the given pid, or any child
+// if pid is -1. With WNOHANG, return 0 instead of blocking when
+// the child hasn't exited yet. Return -1 if there is no such child.
+// Reaping is O(1) when pid is -1 and a zombie exists.
+int
+waitpid(int pid, uint64 addr, int options)
+{
+  struct proc *pp;
+  int xpid;
+  struct proc *p = myproc();
+
+  acquire(&p->kidlock);
+
+  for(;;){
+    // Look for an exited child on the zombies list.
+    for(pp = p->zombies; pp; pp = pp->sibling)
+      if(pid == -1 || pp->pid == pid)
+        break;
+
+    if(pp){
+      // make sure the child isn't still in exit() or swtch().
+      acquire(&pp->lock);
+      xpid = pp->pid;
+      if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
+                              sizeof(pp->xstate)) < 0) {
+        release(&pp->lock);
+        release(&p->kidlock);
+        return -1;
+      }
+      kid_unlink(pp);
+      freeproc(pp);
+      release(&pp->lock);
+      release(&p->kidlock);
+      return xpid;
+    }
+
+    // No point waiting if we don't have such a child.
+    int havekids = 0;
+    for(pp = p->children; pp; pp = pp->sibling)
+      if(pid == -1 || pp->pid == pid){
+        havekids = 1;
+        break;
+      }
+    if(!havekids || killed(p)){
+      release(&p->kidlock);
+      return -1;
+    }
+    if(options & WNOHANG){
+      release(&p->kidlock);
+      return 0;
+    }
+    
+    // Wait for a child to exit.
+    sleep(p, &p->kidlock);  //DOC: wait-sleep
+  }
+}
+
+// Task 3.1: gang scheduling. Processes that called setgang() with
+// the same id want to be on CPU at the same time, e.g. the two
+// sides of a lock-step mailbox pipeline. Before each pick, a CPU
+// looks at what the other CPUs are running and, if one of them is
+// a gang member, runs a RUNNABLE member of the same gang first.
+// With no partner runnable, or no other CPU free to run one, this
+// falls back to the plain round robin. At most GANGBURST gang
+// picks in a row, so gangs can't starve the other processes.
+#define GANGBURST 4
+
+// Put p in gang gid, or in none if gid is 0, linking it on or
+// off ganglist. p->lock must not be held.
+static void
+gang_set(struct proc *p, int gid)
+{
+  acquire(&gang_lock);
+  acquire(&p->lock);
+  if(p->gang == 0 && gid != 0){
+    p->gangnext = ganglist;
+    if(ganglist)
+      ganglist->gangprev = &p->gangnext;
+    ganglist = p;
+    p->gangprev = &ganglist;
+  } else if(p->gang != 0 && gid == 0){
+    *p->gangprev = p->gangnext;
+    if(p->gangnext)
+      p->gangnext->gangprev = p->gangprev;
+    p->gangnext = 0;
+    p->gangprev = 0;
+  }
+  p->gang = gid;
+  release(&p->lock);
+  release(&gang_lock);
+}
+
+// Return a RUNNABLE process, with its lock held, whose gang is
+// running on another CPU, or 0. Other CPUs' c->proc and p->gang
+// are read without locks; struct procs are never freed, and the
+// match is checked again under p->lock.
+static struct proc*
+gangpick(struct cpu *c)
+{
+  int gangs[NCPU];
+  int n = 0;
+  struct proc *p;
+
+  if(ganglist == 0)
+    return 0;
+  for(struct cpu *o = cpus; o < &cpus[NCPU]; o++){
+    p = o->proc;
+    if(o != c && p && p->gang)
+      gangs[n++] = p->gang;
+  }
+  if(n == 0)
+    return 0;
+
+  acquire(&gang_lock);
+  for(p = ganglist; p; p = p->gangnext){
+    for(int i = 0; i < n; i++){
+      if(p->gang != gangs[i])
+        continue;
+      acquire(&p->lock);
+      if(p->state == RUNNABLE){
+        release(&gang_lock);
+        return p;
+      }
+      release(&p->lock);
+      break;
+    }
+  }
+  release(&gang_lock);
+  return 0;
+}
+
+// Run p, which is RUNNABLE and locked, until it gives up the CPU.
+// Returns the process whose lock is held when the CPU comes back.
+static struct proc*
+runproc(struct cpu *c, struct proc *p)
+{
+  struct proc *q;
+
+  // Switch to chosen process.  It is the process's job
+  // to release its lock and then reacquire it
+  // before jumping back to us.
+  // Task 3.1: every client blocked on a mailbox p serves
+  // lends p its own turn, so p runs one extra quantum per
+  // waiting client while it stays runnable. The loans are
+  // counted when p is picked.
+  int loans = p->loans;
+  for(int turn = 0; turn <= loans; turn++){
+    p->state = RUNNING;
+    c->proc = p;
+    kstack_sync(c);
+    swtch(&c->context, &p->context);
+
+    // Process is done running for now.
+    // It should have changed its p->state before coming back.
+    // Task 3.1: after a yield_to() handoff the process coming
+    // back is not the one we switched to; its lock is held,
+    // and p's remaining turns are given up.
+    q = c->proc;
+    c->proc = 0;
+    if(q != p)
+      return q;
+    if(p->state != RUNNABLE)
+      break;
+  }
+  return p;
+}
+
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+// Scheduler never returns.  It loops, doing:
+//  - choose a process to run.
+//  - swtch to start running that process.
+//  - eventually that process transfers control
+//    via swtch back to the scheduler.
+void
+scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+
+  c->proc = 0;
+  for(;;){
+    // The most recent process to run may have had interrupts
+    // turned off; enable them to avoid a deadlock if all
+    // processes are waiting. Then turn them back off
+    // to avoid a possible race between an interrupt
+    // and wfi.
+    intr_on();
+    intr_off();
+
+    int found = 0;
+    for(p = allproc; p; p = p->allnext) {
+      struct proc *g;
+      if(c->gangpicks < GANGBURST && (g = gangpick(c)) != 0){
+        c->gangpicks++;
+        g = runproc(c, g);
+        release(&g->lock);
+        found = 1;
+      }
+
+      // Task 3.1: the process coming back (q) may not be p after a
+      // yield_to() handoff; p stays the allproc cursor either way.
+      struct proc *q = p;
+      acquire(&p->lock);
+      if(p->state == RUNNABLE) {
+        c->gangpicks = 0;
+        q = runproc(c, p);
+        found = 1;
+      }
+      release(&q->lock);
+    }
+    if(found == 0) {
+      // nothing to run; stop running on this core until an interrupt.
+      asm volatile("wfi");
+    }
+  }
+}
+
+// Switch to scheduler.  Must hold only p->lock
+// and have changed proc->state. Saves and restores
+// intena because intena is a property of this
+// kernel thread, not this CPU. It should
+// be proc->intena and proc->noff, but that would
+// break in the few places where a lock is held but
+// there's no process.
+void
+sched(void)
+{
+  int intena;
+  struct proc *p = myproc();
+
+  if(!holding(&p->lock))
+    panic("sched p->lock");
+  if(mycpu()->noff != 1)
+    panic("sched locks");
+  if(p->state == RUNNING)
+    panic("sched RUNNING");
+  if(intr_get())
+    panic("sched interruptible");
+
+  intena = mycpu()->intena;
+  swtch(&p->context, &mycpu()->context);
+  mycpu()->intena = intena;
+  handoff_done();
+}
+
+// Task 3.1: a process resumed by a direct switch from another
+// process (handoff()) releases that process's lock, the way
+// scheduler() does after a normal switch.
+static void
+handoff_done(void)
+{
+  struct cpu *c = mycpu();
+  struct proc *prev = c->handoff;
+
+  if(prev){
+    c->handoff = 0;
+    release(&prev->lock);
+  }
+}
+
+// Task 3.1: switch this CPU straight from p to q without a
+// scheduler pass. q runs for the rest of p's quantum.
+// Both locks must be held, p's state already changed and q
+// RUNNABLE. Returns, holding p->lock, when p next runs.
+static void
+handoff(struct proc *p, struct proc *q)
+{
+  int intena;
+  struct cpu *c = mycpu();
+
+  if(c->noff != 2)
+    panic("handoff locks");
+  if(p->state == RUNNING || q->state != RUNNABLE)
+    panic("handoff state");
+
+  intena = c->intena;
+  q->state = RUNNING;
+  c->proc = q;
+  c->handoff = p;
+  kstack_sync(c);
+  swtch(&p->context, &q->context);
+  mycpu()->intena = intena;
+  handoff_done();
+}
+
+// Give up the CPU for one scheduling round.
+void
+yield(void)
+{
+  struct proc *p = myproc();
+  acquire(&p->lock);
+  p->state = RUNNABLE;
+  sched();
+  release(&p->lock);
+}
+
+// A fork child's very first scheduling by scheduler()
+// will swtch to forkret.
+void
+forkret(void)
+{
+  extern char userret[];
+  static int first = 1;
+  struct proc *p = myproc();
+
+  // Still holding p->lock from scheduler.
+  release(&p->lock);
+  handoff_done(); // Task 3.1: or from a yield_to()
+
+  if (first) {
+    // File system initialization must be run in the context of a
+    // regular process (e.g., because it calls sleep), and thus cannot
+    // be run from main().
+    fsinit(ROOTDEV);
+
+    first = 0;
+    // ensure other cores see first=0.
+    __sync_synchronize();
+
+    // We can invoke kexec() now that file system is initialized.
+    // Put the return value (argc) of kexec into a0.
+    p->trapframe->a0 = kexec("/init", (char *[]){ "/init", 0 });
+    if (p->trapframe->a0 == -1) {
+      panic("exec");
+    }
+  }
+
+  // return to user space, mimicing usertrap()'s return.
+  prepare_return();
+  uint64 satp = MAKE_SATP(p->pagetable);
+  uint64 trampoline_userret = TRAMPOLINE + (userret - trampoline);
+  ((void (*)(uint64))trampoline_userret)(satp);
+}
+
+// Sleep on channel chan, releasing condition lock lk.
+// Re-acquires lk when awakened.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  struct proc *p = myproc();
+  struct sleepq *sq = sleepq(chan);
+  
+  // Must acquire p->lock in order to
+  // change p->state and then call sched.
+  // Once we hold the bucket lock, we can be
+  // guaranteed that we won't miss any wakeup
+  // (wakeup locks the bucket),
+  // so it's okay to release lk.
+
+  acquire(&sq->lock);
+  acquire(&p->lock);  //DOC: sleeplock1
+  release(lk);
+
+  if(p->wakepend){
+    // Task 3.1: a timer (timer.c) fired after the caller last
+    // checked its condition; return so it checks again.
+    p->wakepend = 0;
+    release(&p->lock);
+    release(&sq->lock);
+    acquire(lk);
+    return;
+  }
+
+  // Go to sleep.
+  p->chan = chan;
+  p->state = SLEEPING;
+  p->sq_next = sq->head;
+  sq->head = p;
+  p->onsq = 1;
+  release(&sq->lock);
+
+  sched();
+
+  // Tidy up.
+  p->chan = 0;
+  release(&p->lock);
+
+  // wakeup() unlinks the processes it wakes, but kkill() does not.
+  acquire(&sq->lock);
+  if(p->onsq){
+    struct proc **pp;
+    for(pp = &sq->head; *pp != p; pp = &(*pp)->sq_next)
+      ;
+    *pp = p->sq_next;
+    p->onsq = 0;
+  }
+  release(&sq->lock);
+
+  // Reacquire original lock.
+  acquire(lk);
+}
+
+// Wake up all processes sleeping on channel chan.
+// Caller should hold the condition lock.
+void
+wakeup(void *chan)
+{
+  struct proc *p, **pp;
+  struct sleepq *sq = sleepq(chan);
+
+  // Task 3.1: only the processes in chan's bucket.
+  acquire(&sq->lock);
+  for(pp = &sq->head; (p = *pp) != 0; ) {
+    acquire(&p->lock);
+    if(p->state == SLEEPING && p->chan == chan) {
+      p->state = RUNNABLE;
+      *pp = p->sq_next;
+      p->onsq = 0;
+    } else {
+      pp = &p->sq_next;
+    }
+    release(&p->lock);
+  }
+  release(&sq->lock);
+}
+
+// Kill the process with the given pid.
+// The victim won't exit until it tries to return
+// to user space (see usertrap() in trap.c).
+int
+kkill(int pid)
+{
+  struct proc *p;
+
+  if((p = findproc(pid)) == 0)
+    return -1;
+  p->killed = 1;
+  if(p->state == SLEEPING){
+    // Wake process from sleep().
+    p->state = RUNNABLE;
+  }
+  release(&p->lock);
+  return 0;
+}
+
+// Task 3.1
+// Lend the caller's scheduling turn to the process with the given
+// pid, which the caller is about to block on (see mbox_recv()).
+// Returns 0 on success, -1 if there is no such live process.
+int
+sched_lend(int pid)
+{
+  struct proc *p;
+
+  if((p = findproc(pid)) == 0)
+    return -1;
+  if(p->state == ZOMBIE){
+    release(&p->lock);
+    return -1;
+  }
+  p->loans++;
+  release(&p->lock);
+  return 0;
+}
+
+// Revoke a loan made by sched_lend().
+void
+sched_unlend(int pid)
+{
+  struct proc *p;
+
+  if((p = findproc(pid)) == 0)
+    return;
+  if(p->loans > 0)
+    p->loans--;
+  release(&p->lock);
+}
+
+// Task 3.1: directed yield. Give the rest of the caller's quantum
+// to the process with the given pid by switching to it directly.
+// The caller stays RUNNABLE. Returns -1 if that process is not
+// waiting to run (e.g. another CPU picked it first).
+int
+yield_to(int pid)
+{
+  struct proc *p = myproc();
+  struct proc *q;
+
+  if(pid == p->pid || (q = findproc(pid)) == 0)
+    return -1;
+  int found = (q->state == RUNNABLE);
+  release(&q->lock);
+  if(!found)
+    return -1;
+
+  // take both locks in address order, so two processes yielding
+  // to each other can't deadlock, then check q again.
+  if(p < q){
+    acquire(&p->lock);
+    acquire(&q->lock);
+  } else {
+    acquire(&q->lock);
+    acquire(&p->lock);
+  }
+  if(q->pid != pid || q->state != RUNNABLE){
+    release(&q->lock);
+    release(&p->lock);
+    return -1;
+  }
+  p->state = RUNNABLE;
+  handoff(p, q);
+  release(&p->lock);
+  return 0;
+}
+
+// Task 3.1: put the caller in gang gid, or in none if gid is 0.
+// Returns 0, or -1 if gid is negative.
+int
+setgang(int gid)
+{
+  struct proc *p = myproc();
+
+  if(gid < 0)
+    return -1;
+  gang_set(p, gid);
+  return 0;
+}
+
+void
+setkilled(struct proc *p)
+{
+  acquire(&p->lock);
+  p->killed = 1;
+  release(&p->lock);
+}
+
+int
+killed(struct proc *p)
+{
+  int k;
+  
+  acquire(&p->lock);
+  k = p->killed;
+  release(&p->lock);
+  return k;
+}
+
+// Copy to either a user address, or kernel address,
+// depending on usr_dst.
+// Returns 0 on success, -1 on error.
+int
+either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_dst){
+    return copyout(p->pagetable, dst, src, len);
+  } else {
+    memmove((char *)dst, src, len);
+    return 0;
+  }
+}
+
+// Copy from either a user address, or kernel address,
+// depending on usr_src.
+// Returns 0 on success, -1 on error.
+int
+either_copyin(void *dst, int user_src, uint64 src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_src){
+    return copyin(p->pagetable, dst, src, len);
+  } else {
+    memmove(dst, (char*)src, len);
+    return 0;
+  }
+}
+
+// Print a process listing to console.  For debugging.
+// Runs when user types ^P on console.
+// No lock to avoid wedging a stuck machine further.
+void
+procdump(void)
+{
+  static char *states[] = {
+  [UNUSED]    "unused",
+  [USED]      "used",
+  [SLEEPING]  "sleep ",
+  [RUNNABLE]  "runble",
+  [RUNNING]   "run   ",
+  [ZOMBIE]    "zombie"
+  };
+  struct proc *p;
+  char *state;
+
+  printf("\n");
+  for(p = allproc; p; p = p->allnext){
+    if(p->state == UNUSED)
+      continue;
+    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
+      state = states[p->state];
+    else
+      state = "???";
+    printf("%d %s %s", p->pid, state, p->name);
+    printf("\n");
+  }
+}
@@ -0,0 +1,120 @@
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "proc.h"
+#include "prof.h"
+#include "defs.h"
+
+// Task 3.1: sampling profiler. While it is on, every timer
+// interrupt records where its hart was (sepc, pid, user or kernel)
+// in that hart's ring, and prof_read() drains the rings. By default
+// a sample is taken on each clock tick; prof_start(hz) can ask for
+// more timer interrupts than the tick needs, see clockintr().
+static struct profring {
+  struct spinlock lock;
+  uint head, tail;       // next to read, next to write
+  struct profsample buf[PROF_NBUF];
+} rings[NCPU];
+
+static volatile int profiling;
+static uint64 period;    // time CSR cycles between samples, 0 for every tick
+static int dropped;      // samples lost to full rings since prof_start()
+
+void
+profinit(void)
+{
+  for(int i = 0; i < NCPU; i++)
+    initlock(&rings[i].lock, "prof");
+}
+
+// Called by clockintr() with interrupts off. Take a sample if the
+// profiler is on, and return when the next timer interrupt should
+// be, given that the next clock tick is due at next.
+uint64
+prof_tick(uint64 next)
+{
+  if(!profiling)
+    return next;
+
+  struct profring *r = &rings[cpuid()];
+  struct proc *p = myproc();
+
+  acquire(&r->lock);
+  if(r->tail - r->head < PROF_NBUF){
+    struct profsample *s = &r->buf[r->tail++ % PROF_NBUF];
+    s->pc = r_sepc();
+    s->user = (r_sstatus() & SSTATUS_SPP) == 0;
+    s->cpu = cpuid();
+    s->pid = p ? p->pid : 0;
+    if(p)
+      safestrcpy(s->name, p->name, sizeof(s->name));
+    else
+      s->name[0] = 0;
+  } else {
+    __sync_fetch_and_add(&dropped, 1);
+  }
+  release(&r->lock);
+
+  if(period && r_time() + period < next)
+    next = r_time() + period;
+  return next;
+}
+
+// Empty the rings and start sampling, hz times a second on each
+// CPU, or on every clock tick if hz is 0. Returns 0, or -1 if hz
+// is out of range.
+int
+prof_start(int hz)
+{
+  if(hz < 0 || hz > PROF_MAXHZ)
+    return -1;
+  profiling = 0;
+  for(int i = 0; i < NCPU; i++){
+    acquire(&rings[i].lock);
+    rings[i].head = rings[i].tail = 0;
+    release(&rings[i].lock);
+  }
+  dropped = 0;
+  period = hz ? 10000000 / hz : 0; // the time CSR runs at 10 MHz
+  __sync_synchronize();
+  profiling = 1;
+  return 0;
+}
+
+// Stop sampling. Returns the number of samples dropped because a
+// ring was full; the ones already taken can still be read.
+int
+prof_stop(void)
+{
+  profiling = 0;
+  __sync_synchronize();
+  return dropped;
+}
+
+// Copy up to n samples, oldest first within each CPU, to the user
+// array at addr. Returns how many were copied, or -1.
+int
+prof_read(uint64 addr, int n)
+{
+  struct profsample s;
+  int got = 0;
+
+  for(int i = 0; i < NCPU && got < n; i++){
+    struct profring *r = &rings[i];
+    while(got < n){
+      acquire(&r->lock);
+      if(r->head == r->tail){
+        release(&r->lock);
+        break;
+      }
+      s = r->buf[r->head++ % PROF_NBUF];
+      release(&r->lock);
+      if(copyout(myproc()->pagetable, addr + got * sizeof(s), (char *)&s, sizeof(s)) < 0)
+        return -1;
+      got++;
+    }
+  }
+  return got;
+}
@@ -0,0 +1,12 @@
+// Task 3.1: sampling profiler, shared with user/prof.c.
+#define PROF_NBUF   1024    // samples each CPU's ring holds
+#define PROF_MAXHZ  5000    // highest rate prof_start() accepts
+
+// one sample, taken by a timer interrupt.
+struct profsample {
+  uint64 pc;           // sepc at the interrupt
+  int pid;             // 0 if the hart was in the scheduler
+  uchar cpu;           // hart the sample was taken on
+  uchar user;          // 1 if pc is a user address
+  char name[16];       // process name, "" if pid is 0
+};
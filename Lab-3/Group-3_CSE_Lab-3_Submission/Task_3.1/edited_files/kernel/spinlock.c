@@ -0,0 +1,246 @@
+// Mutual exclusion spin locks.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "proc.h"
+#include "lockstat.h"
+#include "defs.h"
+
+// Task 3.1: lock statistics. Each lock name gets a row; every CPU
+// counts in its own copy of the row with interrupts off, so keeping
+// the statistics adds no shared writes to acquire() and release().
+// lockstats() adds the CPUs' copies up.
+static char *statnames[NLOCKSTAT];
+static int nstatnames;
+static uint statlock;    // protects statnames; initlock() can't use a spinlock
+
+static struct lockcount {
+  uint64 acquires;
+  uint64 contended;
+  uint64 spincycles;
+  uint64 maxhold;
+} lockcounts[NCPU][NLOCKSTAT];
+
+// The statistics row for locks called name, or -1 if the table is full.
+static int
+statrow(char *name)
+{
+  int i;
+
+  while(__sync_lock_test_and_set(&statlock, 1) != 0)
+    ;
+  __sync_synchronize();
+  for(i = 0; i < nstatnames; i++)
+    if(statnames[i] == name || strncmp(statnames[i], name, 16) == 0)
+      break;
+  if(i == nstatnames){
+    if(nstatnames < NLOCKSTAT)
+      statnames[nstatnames++] = name;
+    else
+      i = -1;
+  }
+  __sync_synchronize();
+  __sync_lock_release(&statlock);
+  return i;
+}
+
+void
+initlock(struct spinlock *lk, char *name)
+{
+  lk->name = name;
+  lk->locked = 0;
+  lk->cpu = 0;
+  lk->ticket = 0;
+  lk->next = lk->owner = 0;
+  lk->stat = statrow(name);
+}
+
+// Task 3.1: initialize lk as a ticket lock. acquire() then serves
+// waiters first come, first served, so a hart can't be starved by
+// the others winning the race for locked every time. Each waiter
+// also backs off in proportion to its place in the queue, so fewer
+// harts read the lock's cache line on each hand-over. Used for the
+// global locks that all harts take.
+void
+initticketlock(struct spinlock *lk, char *name)
+{
+  initlock(lk, name);
+  lk->ticket = 1;
+}
+
+// Acquire the lock.
+// Loops (spins) until the lock is acquired.
+void
+acquire(struct spinlock *lk)
+{
+  push_off(); // disable interrupts to avoid deadlock.
+  if(holding(lk))
+    panic("acquire");
+
+  // Task 3.1: the time CSR is only read once the lock turns out
+  // to be held, so uncontended acquires cost no more than before.
+  uint64 start = 0;
+
+  if(lk->ticket){
+    // Task 3.1: take a ticket and wait for it to be served.
+    uint t = __sync_fetch_and_add(&lk->next, 1);
+    uint ahead;
+    while((ahead = t - *(volatile uint *)&lk->owner) != 0){
+      if(start == 0)
+        start = r_time();
+      for(uint i = 0; i < ahead * 16; i++)
+        asm volatile("nop");
+    }
+    __sync_synchronize();
+    lk->locked = 1;
+  } else {
+    // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
+    //   a5 = 1
+    //   s1 = &lk->locked
+    //   amoswap.w.aq a5, a5, (s1)
+    while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
+      if(start == 0)
+        start = r_time();
+  }
+
+  // Tell the C compiler and the processor to not move loads or stores
+  // past this point, to ensure that the critical section's memory
+  // references happen strictly after the lock is acquired.
+  // On RISC-V, this emits a fence instruction.
+  __sync_synchronize();
+
+  // Record info about lock acquisition for holding() and debugging.
+  lk->cpu = mycpu();
+
+  if(lk->stat >= 0){
+    struct lockcount *lc = &lockcounts[cpuid()][lk->stat];
+    lc->acquires++;
+    if(start){
+      lc->contended++;
+      lc->spincycles += r_time() - start;
+    }
+  }
+#ifdef LOCKHOLD
+  lk->since = r_time();
+#endif
+}
+
+// Release the lock.
+void
+release(struct spinlock *lk)
+{
+  if(!holding(lk))
+    panic("release");
+
+#ifdef LOCKHOLD
+  if(lk->stat >= 0){
+    struct lockcount *lc = &lockcounts[cpuid()][lk->stat];
+    uint64 held = r_time() - lk->since;
+    if(held > lc->maxhold)
+      lc->maxhold = held;
+  }
+#endif
+
+  lk->cpu = 0;
+
+  // Tell the C compiler and the CPU to not move loads or stores
+  // past this point, to ensure that all the stores in the critical
+  // section are visible to other CPUs before the lock is released,
+  // and that loads in the critical section occur strictly before
+  // the lock is released.
+  // On RISC-V, this emits a fence instruction.
+  __sync_synchronize();
+
+  if(lk->ticket){
+    // Task 3.1: serve the next ticket. Only the holder writes
+    // owner, so a plain store is enough.
+    lk->locked = 0;
+    __sync_synchronize();
+    *(volatile uint *)&lk->owner = lk->owner + 1;
+  } else {
+    // Release the lock, equivalent to lk->locked = 0.
+    // This code doesn't use a C assignment, since the C standard
+    // implies that an assignment might be implemented with
+    // multiple store instructions.
+    // On RISC-V, sync_lock_release turns into an atomic swap:
+    //   s1 = &lk->locked
+    //   amoswap.w zero, zero, (s1)
+    __sync_lock_release(&lk->locked);
+  }
+
+  pop_off();
+}
+
+// Check whether this cpu is holding the lock.
+// Interrupts must be off.
+int
+holding(struct spinlock *lk)
+{
+  int r;
+  r = (lk->locked && lk->cpu == mycpu());
+  return r;
+}
+
+// push_off/pop_off are like intr_off()/intr_on() except that they are matched:
+// it takes two pop_off()s to undo two push_off()s.  Also, if interrupts
+// are initially off, then push_off, pop_off leaves them off.
+
+void
+push_off(void)
+{
+  int old = intr_get();
+
+  // disable interrupts to prevent an involuntary context
+  // switch while using mycpu().
+  intr_off();
+
+  if(mycpu()->noff == 0)
+    mycpu()->intena = old;
+  mycpu()->noff += 1;
+}
+
+void
+pop_off(void)
+{
+  struct cpu *c = mycpu();
+  if(intr_get())
+    panic("pop_off - interruptible");
+  if(c->noff < 1)
+    panic("pop_off");
+  c->noff -= 1;
+  if(c->noff == 0 && c->intena)
+    intr_on();
+}
+
+// Task 3.1: copy the statistics of up to n lock names, summed over
+// the CPUs, to the user array at addr, then zero them if reset is
+// set. Counters are read without stopping the other CPUs, so they
+// may be off by the acquisitions that happen meanwhile.
+// Returns the number of entries copied, or -1.
+int
+lockstats(uint64 addr, int n, int reset)
+{
+  struct lockstat ls;
+  int i;
+
+  for(i = 0; i < n && i < nstatnames; i++){
+    memset(&ls, 0, sizeof(ls));
+    safestrcpy(ls.name, statnames[i], sizeof(ls.name));
+    for(int c = 0; c < NCPU; c++){
+      struct lockcount *lc = &lockcounts[c][i];
+      ls.acquires += lc->acquires;
+      ls.contended += lc->contended;
+      ls.spincycles += lc->spincycles;
+      if(lc->maxhold > ls.maxhold)
+        ls.maxhold = lc->maxhold;
+    }
+    if(copyout(myproc()->pagetable, addr + i * sizeof(ls), (char *)&ls, sizeof(ls)) < 0)
+      return -1;
+  }
+  if(reset)
+    memset(lockcounts, 0, sizeof(lockcounts));
+  return i;
+}
@@ -0,0 +1,18 @@
+// Mutual exclusion lock.
+struct spinlock {
+  uint locked;       // Is the lock held?
+
+  // Task 3.1: ticket mode, see initticketlock(). Waiters take a
+  // ticket and are served in order instead of racing for locked.
+  int ticket;        // 1 if this is a ticket lock
+  uint next;         // next ticket to hand out
+  uint owner;        // ticket now being served
+
+  // For debugging:
+  char *name;        // Name of lock.
+  struct cpu *cpu;   // The cpu holding the lock.
+
+  // Task 3.1: statistics, see lockstats().
+  int stat;          // lock name's row in the statistics, -1 if none
+  uint64 since;      // time CSR when it was acquired, if LOCKHOLD
+};
@@ -1,166 +1,238 @@
-#include "types.h"
-#include "param.h"
-#include "memlayout.h"
-#include "riscv.h"
-#include "spinlock.h"
-#include "proc.h"
-#include "syscall.h"
-#include "defs.h"
-
-// Fetch the uint64 at addr from the current process.
-int
-fetchaddr(uint64 addr, uint64 *ip)
-{
-  struct proc *p = myproc();
-  if(addr >= p->sz || addr+sizeof(uint64) > p->sz) // both tests needed, in case of overflow
-    return -1;
-  if(copyin(p->pagetable, (char *)ip, addr, sizeof(*ip)) != 0)
-    return -1;
-  return 0;
-}
-
-// Fetch the nul-terminated string at addr from the current process.
-// Returns length of string, not including nul, or -1 for error.
-int
-fetchstr(uint64 addr, char *buf, int max)
-{
-  struct proc *p = myproc();
-  if(copyinstr(p->pagetable, buf, addr, max) < 0)
-    return -1;
-  return strlen(buf);
-}
-
-static uint64
-argraw(int n)
-{
-  struct proc *p = myproc();
-  switch (n) {
-  case 0:
-    return p->trapframe->a0;
-  case 1:
-    return p->trapframe->a1;
-  case 2:
-    return p->trapframe->a2;
-  case 3:
-    return p->trapframe->a3;
-  case 4:
-    return p->trapframe->a4;
-  case 5:
-    return p->trapframe->a5;
-  }
-  panic("argraw");
-  return -1;
-}
-
-// Fetch the nth 32-bit system call argument.
-void
-argint(int n, int *ip)
-{
-  *ip = argraw(n);
-}
-
-// Retrieve an argument as a pointer.
-// Doesn't check for legality, since
-// copyin/copyout will do that.
-void
-argaddr(int n, uint64 *ip)
-{
-  *ip = argraw(n);
-}
-
-// Fetch the nth word-sized system call argument as a null-terminated string.
-// Copies into buf, at most max.
-// Returns string length if OK (including nul), -1 if error.
-int
-argstr(int n, char *buf, int max)
-{
-  uint64 addr;
-  argaddr(n, &addr);
-  return fetchstr(addr, buf, max);
-}
-
-// Prototypes for the functions that handle system calls.
-extern uint64 sys_fork(void);
-extern uint64 sys_exit(void);
-extern uint64 sys_wait(void);
-extern uint64 sys_pipe(void);
-extern uint64 sys_read(void);
-extern uint64 sys_kill(void);
-extern uint64 sys_exec(void);
-extern uint64 sys_fstat(void);
-extern uint64 sys_chdir(void);
-extern uint64 sys_dup(void);
-extern uint64 sys_getpid(void);
-extern uint64 sys_sbrk(void);
-extern uint64 sys_pause(void);
-extern uint64 sys_uptime(void);
-extern uint64 sys_open(void);
-extern uint64 sys_write(void);
-extern uint64 sys_mknod(void);
-extern uint64 sys_unlink(void);
-extern uint64 sys_link(void);
-extern uint64 sys_mkdir(void);
-extern uint64 sys_close(void);
-
-// Task 3.1
-extern uint64 sys_shm_create(void);
-extern uint64 sys_shm_get(void);
-extern uint64 sys_shm_close(void);
-
-extern uint64 sys_mbox_create(void);
-extern uint64 sys_mbox_send(void);
-extern uint64 sys_mbox_recv(void);
-extern uint64 sys_mbox_close(void);
-
-// An array mapping syscall numbers from syscall.h
-// to the function that handles the system call.
-static uint64 (*syscalls[])(void) = {
-[SYS_fork]    sys_fork,
-[SYS_exit]    sys_exit,
-[SYS_wait]    sys_wait,
-[SYS_pipe]    sys_pipe,
-[SYS_read]    sys_read,
-[SYS_kill]    sys_kill,
-[SYS_exec]    sys_exec,
-[SYS_fstat]   sys_fstat,
-[SYS_chdir]   sys_chdir,
-[SYS_dup]     sys_dup,
-[SYS_getpid]  sys_getpid,
-[SYS_sbrk]    sys_sbrk,
-[SYS_pause]   sys_pause,
-[SYS_uptime]  sys_uptime,
-[SYS_open]    sys_open,
-[SYS_write]   sys_write,
-[SYS_mknod]   sys_mknod,
-[SYS_unlink]  sys_unlink,
-[SYS_link]    sys_link,
-[SYS_mkdir]   sys_mkdir,
-[SYS_close]   sys_close,
-
-// Task 3.1
-[SYS_shm_create] sys_shm_create,
-[SYS_shm_get] sys_shm_get,
-[SYS_shm_close] sys_shm_close,
-[SYS_mbox_create] sys_mbox_create,
-[SYS_mbox_send] sys_mbox_send,
-[SYS_mbox_recv] sys_mbox_recv,
-[SYS_mbox_close] sys_mbox_close,
-};
-
-void
-syscall(void)
-{
-  int num;
-  struct proc *p = myproc();
-
-  num = p->trapframe->a7;
-  if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
-    // Use num to lookup the system call function for num, call it,
-    // and store its return value in p->trapframe->a0
-    p->trapframe->a0 = syscalls[num]();
-  } else {
-    printf("%d %s: unknown sys call %d\n",
-            p->pid, p->name, num);
-    p->trapframe->a0 = -1;
-  }
-}
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "syscall.h"
+#include "syscallstat.h"
+#include "defs.h"
+
+// Fetch the uint64 at addr from the current process.
+int
+fetchaddr(uint64 addr, uint64 *ip)
+{
+  struct proc *p = myproc();
+  if(addr >= p->sz || addr+sizeof(uint64) > p->sz) // both tests needed, in case of overflow
+    return -1;
+  if(copyin(p->pagetable, (char *)ip, addr, sizeof(*ip)) != 0)
+    return -1;
+  return 0;
+}
+
+// Fetch the nul-terminated string at addr from the current process.
+// Returns length of string, not including nul, or -1 for error.
+int
+fetchstr(uint64 addr, char *buf, int max)
+{
+  struct proc *p = myproc();
+  if(copyinstr(p->pagetable, buf, addr, max) < 0)
+    return -1;
+  return strlen(buf);
+}
+
+static uint64
+argraw(int n)
+{
+  struct proc *p = myproc();
+  switch (n) {
+  case 0:
+    return p->trapframe->a0;
+  case 1:
+    return p->trapframe->a1;
+  case 2:
+    return p->trapframe->a2;
+  case 3:
+    return p->trapframe->a3;
+  case 4:
+    return p->trapframe->a4;
+  case 5:
+    return p->trapframe->a5;
+  }
+  panic("argraw");
+  return -1;
+}
+
+// Fetch the nth 32-bit system call argument.
+void
+argint(int n, int *ip)
+{
+  *ip = argraw(n);
+}
+
+// Retrieve an argument as a pointer.
+// Doesn't check for legality, since
+// copyin/copyout will do that.
+void
+argaddr(int n, uint64 *ip)
+{
+  *ip = argraw(n);
+}
+
+// Fetch the nth word-sized system call argument as a null-terminated string.
+// Copies into buf, at most max.
+// Returns string length if OK (including nul), -1 if error.
+int
+argstr(int n, char *buf, int max)
+{
+  uint64 addr;
+  argaddr(n, &addr);
+  return fetchstr(addr, buf, max);
+}
+
+// Prototypes for the functions that handle system calls.
+extern uint64 sys_fork(void);
+extern uint64 sys_exit(void);
+extern uint64 sys_wait(void);
+extern uint64 sys_pipe(void);
+extern uint64 sys_read(void);
+extern uint64 sys_kill(void);
+extern uint64 sys_exec(void);
+extern uint64 sys_fstat(void);
+extern uint64 sys_chdir(void);
+extern uint64 sys_dup(void);
+extern uint64 sys_getpid(void);
+extern uint64 sys_sbrk(void);
+extern uint64 sys_pause(void);
+extern uint64 sys_uptime(void);
+extern uint64 sys_open(void);
+extern uint64 sys_write(void);
+extern uint64 sys_mknod(void);
+extern uint64 sys_unlink(void);
+extern uint64 sys_link(void);
+extern uint64 sys_mkdir(void);
+extern uint64 sys_close(void);
+
+// Task 3.1
+extern uint64 sys_shm_create(void);
+extern uint64 sys_shm_get(void);
+extern uint64 sys_shm_close(void);
+
+extern uint64 sys_mbox_create(void);
+extern uint64 sys_mbox_send(void);
+extern uint64 sys_mbox_recv(void);
+extern uint64 sys_mbox_close(void);
+extern uint64 sys_mbox_bind_server(void);
+extern uint64 sys_yield_to(void);
+extern uint64 sys_waitpid(void);
+extern uint64 sys_setgang(void);
+extern uint64 sys_prof_start(void);
+extern uint64 sys_prof_stop(void);
+extern uint64 sys_prof_read(void);
+extern uint64 sys_syscallstats(void);
+extern uint64 sys_lockstats(void);
+
+// An array mapping syscall numbers from syscall.h
+// to the function that handles the system call.
+static uint64 (*syscalls[])(void) = {
+[SYS_fork]    sys_fork,
+[SYS_exit]    sys_exit,
+[SYS_wait]    sys_wait,
+[SYS_pipe]    sys_pipe,
+[SYS_read]    sys_read,
+[SYS_kill]    sys_kill,
+[SYS_exec]    sys_exec,
+[SYS_fstat]   sys_fstat,
+[SYS_chdir]   sys_chdir,
+[SYS_dup]     sys_dup,
+[SYS_getpid]  sys_getpid,
+[SYS_sbrk]    sys_sbrk,
+[SYS_pause]   sys_pause,
+[SYS_uptime]  sys_uptime,
+[SYS_open]    sys_open,
+[SYS_write]   sys_write,
+[SYS_mknod]   sys_mknod,
+[SYS_unlink]  sys_unlink,
+[SYS_link]    sys_link,
+[SYS_mkdir]   sys_mkdir,
+[SYS_close]   sys_close,
+
+// Task 3.1
+[SYS_shm_create] sys_shm_create,
+[SYS_shm_get] sys_shm_get,
+[SYS_shm_close] sys_shm_close,
+[SYS_mbox_create] sys_mbox_create,
+[SYS_mbox_send] sys_mbox_send,
+[SYS_mbox_recv] sys_mbox_recv,
+[SYS_mbox_close] sys_mbox_close,
+[SYS_mbox_bind_server] sys_mbox_bind_server,
+[SYS_yield_to] sys_yield_to,
+[SYS_waitpid] sys_waitpid,
+[SYS_setgang] sys_setgang,
+[SYS_prof_start] sys_prof_start,
+[SYS_prof_stop] sys_prof_stop,
+[SYS_prof_read] sys_prof_read,
+[SYS_syscallstats] sys_syscallstats,
+[SYS_lockstats] sys_lockstats,
+};
+
+// Task 3.1: count and latency of each syscall, kept per CPU so the
+// dispatcher never shares a cache line with another hart. A call is
+// counted on the CPU it returns on; syscallstats() adds them up.
+static struct syscallstat scstats[NCPU][SYSST_NSYS];
+
+static void
+scstat_add(int num, uint64 cycles)
+{
+  int b = 0;
+  while(b < SYSST_NLAT - 1 && (cycles >> (b + 1)) != 0)
+    b++;
+
+  // stay on this CPU while updating its table.
+  push_off();
+  struct syscallstat *st = &scstats[cpuid()][num];
+  st->count++;
+  st->cycles += cycles;
+  st->lat[b]++;
+  pop_off();
+}
+
+// Copy the totals for syscalls 0 to n-1 to the user array at addr,
+// indexed by syscall number, then zero the tables if reset is set.
+// Counters are read and reset without stopping the other CPUs, so
+// a call that returns meanwhile may be counted in neither copy.
+// Returns the number of entries copied, or -1.
+int
+syscallstats(uint64 addr, int n, int reset)
+{
+  struct syscallstat sum;
+
+  if(n > SYSST_NSYS)
+    n = SYSST_NSYS;
+  for(int num = 0; num < n; num++){
+    memset(&sum, 0, sizeof(sum));
+    for(int c = 0; c < NCPU; c++){
+      struct syscallstat *st = &scstats[c][num];
+      sum.count += st->count;
+      sum.cycles += st->cycles;
+      for(int b = 0; b < SYSST_NLAT; b++)
+        sum.lat[b] += st->lat[b];
+    }
+    if(copyout(myproc()->pagetable, addr + num * sizeof(sum), (char *)&sum, sizeof(sum)) < 0)
+      return -1;
+  }
+  if(reset)
+    memset(scstats, 0, sizeof(scstats));
+  return n;
+}
+
+void
+syscall(void)
+{
+  int num;
+  struct proc *p = myproc();
+
+  num = p->trapframe->a7;
+  if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+    // Use num to lookup the system call function for num, call it,
+    // and store its return value in p->trapframe->a0
+    uint64 start = r_time();
+    p->trapframe->a0 = syscalls[num]();
+    if(num < SYSST_NSYS)
+      scstat_add(num, r_time() - start);
+  } else {
+    printf("%d %s: unknown sys call %d\n",
+            p->pid, p->name, num);
+    p->trapframe->a0 = -1;
+  }
+}
@@ -1,32 +1,41 @@
-// System call numbers
-#define SYS_fork    1
-#define SYS_exit    2
-#define SYS_wait    3
-#define SYS_pipe    4
-#define SYS_read    5
-#define SYS_kill    6
-#define SYS_exec    7
-#define SYS_fstat   8
-#define SYS_chdir   9
-#define SYS_dup    10
-#define SYS_getpid 11
-#define SYS_sbrk   12
-#define SYS_pause  13
-#define SYS_uptime 14
-#define SYS_open   15
-#define SYS_write  16
-#define SYS_mknod  17
-#define SYS_unlink 18
-#define SYS_link   19
-#define SYS_mkdir  20
-#define SYS_close  21
-
-// Task 3.1
-#define SYS_shm_create 22
-#define SYS_shm_get 23
-#define SYS_shm_close 24
-
-#define SYS_mbox_create 25
-#define SYS_mbox_send 26
-#define SYS_mbox_recv 27
-#define SYS_mbox_close 28
+// System call numbers
+#define SYS_fork    1
+#define SYS_exit    2
+#define SYS_wait    3
+#define SYS_pipe    4
+#define SYS_read    5
+#define SYS_kill    6
+#define SYS_exec    7
+#define SYS_fstat   8
+#define SYS_chdir   9
+#define SYS_dup    10
+#define SYS_getpid 11
+#define SYS_sbrk   12
+#define SYS_pause  13
+#define SYS_uptime 14
+#define SYS_open   15
+#define SYS_write  16
+#define SYS_mknod  17
+#define SYS_unlink 18
+#define SYS_link   19
+#define SYS_mkdir  20
+#define SYS_close  21
+
+// Task 3.1
+#define SYS_shm_create 22
+#define SYS_shm_get 23
+#define SYS_shm_close 24
+
+#define SYS_mbox_create 25
+#define SYS_mbox_send 26
+#define SYS_mbox_recv 27
+#define SYS_mbox_close 28
+#define SYS_mbox_bind_server 29
+#define SYS_yield_to 30
+#define SYS_waitpid 31
+#define SYS_setgang 32
+#define SYS_prof_start 33
+#define SYS_prof_stop  34
+#define SYS_prof_read  35
+#define SYS_syscallstats 36
+#define SYS_lockstats  37
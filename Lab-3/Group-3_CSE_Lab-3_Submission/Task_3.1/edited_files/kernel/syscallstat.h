@@ -0,0 +1,13 @@
+// Task 3.1: per-syscall statistics, returned by syscallstats().
+#define SYSST_NSYS  64    // syscall numbers tracked, 1 to SYSST_NSYS-1
+
+// lat[b] counts calls that took [2^b, 2^(b+1)) time CSR cycles,
+// at 10 MHz so 100ns a cycle; bucket 0 also holds 0 cycles and the
+// last bucket everything longer.
+#define SYSST_NLAT  24
+
+struct syscallstat {
+  uint64 count;        // calls that returned
+  uint64 cycles;       // time CSR cycles spent in them
+  uint lat[SYSST_NLAT];
+};
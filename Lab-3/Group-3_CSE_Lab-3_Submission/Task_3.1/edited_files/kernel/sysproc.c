@@ -1,171 +1,274 @@
-#include "types.h"
-#include "riscv.h"
-#include "defs.h"
-#include "param.h"
-#include "memlayout.h"
-#include "spinlock.h"
-#include "proc.h"
-#include "vm.h"
-
-uint64
-sys_exit(void)
-{
-  int n;
-  argint(0, &n);
-  kexit(n);
-  return 0;  // not reached
-}
-
-uint64
-sys_getpid(void)
-{
-  return myproc()->pid;
-}
-
-uint64
-sys_fork(void)
-{
-  return kfork();
-}
-
-uint64
-sys_wait(void)
-{
-  uint64 p;
-  argaddr(0, &p);
-  return kwait(p);
-}
-
-uint64
-sys_sbrk(void)
-{
-  uint64 addr;
-  int t;
-  int n;
-
-  argint(0, &n);
-  argint(1, &t);
-  addr = myproc()->sz;
-
-  if(t == SBRK_EAGER || n < 0) {
-    if(growproc(n) < 0) {
-      return -1;
-    }
-  } else {
-    // Lazily allocate memory for this process: increase its memory
-    // size but don't allocate memory. If the processes uses the
-    // memory, vmfault() will allocate it.
-    if(addr + n < addr)
-      return -1;
-    myproc()->sz += n;
-  }
-  return addr;
-}
-
-uint64
-sys_pause(void)
-{
-  int n;
-  uint ticks0;
-
-  argint(0, &n);
-  if(n < 0)
-    n = 0;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
-}
-
-uint64
-sys_kill(void)
-{
-  int pid;
-
-  argint(0, &pid);
-  return kkill(pid);
-}
-
-// return how many clock tick interrupts have occurred
-// since start.
-uint64
-sys_uptime(void)
-{
-  uint xticks;
-
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
-}
-
-// Task 3.1
-uint64
-sys_shm_create(void)
-{
-  int key;
-  argint(0, &key);
-  return shm_create(key);
-}
-
-uint64
-sys_shm_get(void)
-{
-  int key;
-  argint(0, &key);
-  return shm_get(key);
-}
-
-uint64
-sys_shm_close(void)
-{
-  int key;
-  argint(0, &key);
-  return shm_close(key);
-}
-
-uint64
-sys_mbox_create(void)
-{
-  int key;
-  argint(0, &key);
-  return mbox_create(key);
-}
-
-uint64
-sys_mbox_send(void)
-{
-  int id, msg;
-  argint(0, &id);
-  argint(1, &msg);
-  return mbox_send(id, msg);
-}
-
-uint64
-sys_mbox_recv(void)
-{
-  int id;
-  uint64 msg;
-  argint(0, &id);
-  argaddr(1, (uint64*)&msg);
-
-  int v = 0;
-  if (mbox_recv(id, &v) < 0) return -1;
-  if (copyout(myproc()->pagetable, msg, (char*)&v, sizeof(v)) < 0) return -1;
-  return 0;
-}
-
-uint64
-sys_mbox_close(void)
-{
-  int id;
-  argint(0, &id);
-  return mbox_close(id);
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "vm.h"
+#include "timer.h"
+
+uint64
+sys_exit(void)
+{
+  int n;
+  argint(0, &n);
+  kexit(n);
+  return 0;  // not reached
+}
+
+uint64
+sys_getpid(void)
+{
+  return myproc()->pid;
+}
+
+uint64
+sys_fork(void)
+{
+  return kfork();
+}
+
+uint64
+sys_wait(void)
+{
+  uint64 p;
+  argaddr(0, &p);
+  return kwait(p);
+}
+
+uint64
+sys_sbrk(void)
+{
+  uint64 addr;
+  int t;
+  int n;
+
+  argint(0, &n);
+  argint(1, &t);
+  addr = myproc()->sz;
+
+  if(t == SBRK_EAGER || n < 0) {
+    if(growproc(n) < 0) {
+      return -1;
+    }
+  } else {
+    // Lazily allocate memory for this process: increase its memory
+    // size but don't allocate memory. If the processes uses the
+    // memory, vmfault() will allocate it.
+    if(addr + n < addr)
+      return -1;
+    myproc()->sz += n;
+  }
+  return addr;
+}
+
+uint64
+sys_pause(void)
+{
+  int n;
+  uint ticks0;
+
+  argint(0, &n);
+  if(n < 0)
+    n = 0;
+  acquire(&tickslock);
+  ticks0 = ticks;
+  // Task 3.1: only woken by the timer wheel when the deadline passes.
+  struct timer t;
+  if(n > 0)
+    timer_add(&t, ticks0 + n);
+  while(ticks - ticks0 < n){
+    if(killed(myproc())){
+      timer_del(&t);
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&t, &tickslock);
+  }
+  release(&tickslock);
+  return 0;
+}
+
+uint64
+sys_kill(void)
+{
+  int pid;
+
+  argint(0, &pid);
+  return kkill(pid);
+}
+
+// return how many clock tick interrupts have occurred
+// since start.
+uint64
+sys_uptime(void)
+{
+  uint xticks;
+
+  acquire(&tickslock);
+  xticks = ticks;
+  release(&tickslock);
+  return xticks;
+}
+
+// Task 3.1
+uint64
+sys_shm_create(void)
+{
+  int key;
+  argint(0, &key);
+  return shm_create(key);
+}
+
+uint64
+sys_shm_get(void)
+{
+  int key;
+  argint(0, &key);
+  return shm_get(key);
+}
+
+uint64
+sys_shm_close(void)
+{
+  int key;
+  argint(0, &key);
+  return shm_close(key);
+}
+
+uint64
+sys_mbox_create(void)
+{
+  int key;
+  argint(0, &key);
+  return mbox_create(key);
+}
+
+uint64
+sys_mbox_send(void)
+{
+  int id, msg;
+  argint(0, &id);
+  argint(1, &msg);
+  return mbox_send(id, msg);
+}
+
+uint64
+sys_mbox_recv(void)
+{
+  int id;
+  uint64 msg;
+  argint(0, &id);
+  argaddr(1, (uint64*)&msg);
+
+  int v = 0;
+  if (mbox_recv(id, &v) < 0) return -1;
+  if (copyout(myproc()->pagetable, msg, (char*)&v, sizeof(v)) < 0) return -1;
+  return 0;
+}
+
+uint64
+sys_mbox_close(void)
+{
+  int id;
+  argint(0, &id);
+  return mbox_close(id);
+}
+
+uint64
+sys_mbox_bind_server(void)
+{
+  int id;
+  argint(0, &id);
+  return mbox_bind_server(id);
+}
+
+uint64
+sys_yield_to(void)
+{
+  int pid;
+  argint(0, &pid);
+  return yield_to(pid);
+}
+
+// waitpid(pid, &status, options): pid -1 waits for any child
+uint64
+sys_waitpid(void)
+{
+  int pid, options;
+  uint64 p;
+
+  argint(0, &pid);
+  argaddr(1, &p);
+  argint(2, &options);
+  return waitpid(pid, p, options);
+}
+
+uint64
+sys_setgang(void)
+{
+  int gid;
+  argint(0, &gid);
+  return setgang(gid);
+}
+
+uint64
+sys_prof_start(void)
+{
+  int hz;
+  argint(0, &hz);
+  return prof_start(hz);
+}
+
+uint64
+sys_prof_stop(void)
+{
+  return prof_stop();
+}
+
+// prof_read(struct profsample *, n): returns the number filled in
+uint64
+sys_prof_read(void)
+{
+  uint64 addr;
+  int n;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  if(n < 0)
+    return -1;
+  return prof_read(addr, n);
+}
+
+// syscallstats(struct syscallstat *, n, reset): returns the number
+// filled in, entry i for syscall number i
+uint64
+sys_syscallstats(void)
+{
+  uint64 addr;
+  int n, reset;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  argint(2, &reset);
+  if(n < 0)
+    return -1;
+  return syscallstats(addr, n, reset);
+}
+
+// lockstats(struct lockstat *, n, reset): returns the number of
+// lock names filled in
+uint64
+sys_lockstats(void)
+{
+  uint64 addr;
+  int n, reset;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  argint(2, &reset);
+  if(n < 0)
+    return -1;
+  return lockstats(addr, n, reset);
 }
\ No newline at end of file
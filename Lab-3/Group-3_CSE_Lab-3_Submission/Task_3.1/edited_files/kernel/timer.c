@@ -0,0 +1,138 @@
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "proc.h"
+#include "timer.h"
+#include "defs.h"
+
+// Task 3.1: a hierarchical timer wheel, so a tick only touches
+// the timers that expire on it instead of waking every sleeper.
+// Level 0 has one slot per tick for the next TVR_SIZE ticks; each
+// higher level has TVN_SIZE slots, each covering a whole lap of
+// the level below. When level 0 wraps around, the next slot of
+// level 1 is cascaded down into it, and so on up the levels.
+// Everything is protected by tickslock.
+static struct {
+  uint base;                      // next tick to run
+  struct timer *tv1[TVR_SIZE];
+  struct timer *tv2[TVN_SIZE];
+  struct timer *tv3[TVN_SIZE];
+  struct timer *tv4[TVN_SIZE];
+} wheel;
+
+static void
+link(struct timer **slot, struct timer *t)
+{
+  t->next = *slot;
+  if(t->next)
+    t->next->pprev = &t->next;
+  *slot = t;
+  t->pprev = slot;
+}
+
+static void
+unlink(struct timer *t)
+{
+  *t->pprev = t->next;
+  if(t->next)
+    t->next->pprev = t->pprev;
+  t->next = 0;
+  t->pprev = 0;
+}
+
+// put t in the slot for its expiry relative to wheel.base.
+static void
+enqueue(struct timer *t)
+{
+  uint expires = t->expires;
+  uint idx = expires - wheel.base;
+
+  if((int)idx < 0){
+    // already due: run on the next tick.
+    link(&wheel.tv1[wheel.base & (TVR_SIZE-1)], t);
+  } else if(idx < TVR_SIZE){
+    link(&wheel.tv1[expires & (TVR_SIZE-1)], t);
+  } else if(idx < 1 << (TVR_BITS + TVN_BITS)){
+    link(&wheel.tv2[(expires >> TVR_BITS) & (TVN_SIZE-1)], t);
+  } else if(idx < 1 << (TVR_BITS + 2*TVN_BITS)){
+    link(&wheel.tv3[(expires >> (TVR_BITS + TVN_BITS)) & (TVN_SIZE-1)], t);
+  } else {
+    // beyond the top level: park it in the furthest slot, it is
+    // put back in the right place when that slot cascades.
+    if(idx >= 1U << (TVR_BITS + 3*TVN_BITS))
+      expires = wheel.base + (1U << (TVR_BITS + 3*TVN_BITS)) - 1;
+    link(&wheel.tv4[(expires >> (TVR_BITS + 2*TVN_BITS)) & (TVN_SIZE-1)], t);
+  }
+}
+
+// move every timer in slot idx of tv down to the lower levels.
+// returns idx: 0 means tv wrapped too and the level above must
+// cascade as well.
+static int
+cascade(struct timer **tv, int idx)
+{
+  struct timer *t = tv[idx];
+
+  tv[idx] = 0;
+  while(t){
+    struct timer *next = t->next;
+    enqueue(t);
+    t = next;
+  }
+  return idx;
+}
+
+// wake the process of a timer that has fired. If it isn't asleep
+// yet, its next sleep() returns at once, so a timeout can't be
+// lost between the caller checking timer_expired() and sleeping.
+static void
+fire(struct proc *p)
+{
+  acquire(&p->lock);
+  if(p->state == SLEEPING)
+    p->state = RUNNABLE;
+  else
+    p->wakepend = 1;
+  release(&p->lock);
+}
+
+// Arm t to wake the calling process at tick expires.
+void
+timer_add(struct timer *t, uint expires)
+{
+  t->expires = expires;
+  t->proc = myproc();
+  enqueue(t);
+}
+
+// Disarm t if it hasn't fired yet.
+void
+timer_del(struct timer *t)
+{
+  if(!timer_expired(t))
+    unlink(t);
+}
+
+// Run every timer due by the current value of ticks.
+void
+timer_tick(void)
+{
+  while((int)(ticks - wheel.base) >= 0){
+    int idx = wheel.base & (TVR_SIZE-1);
+
+    if(idx == 0 &&
+       !cascade(wheel.tv2, (wheel.base >> TVR_BITS) & (TVN_SIZE-1)) &&
+       !cascade(wheel.tv3, (wheel.base >> (TVR_BITS + TVN_BITS)) & (TVN_SIZE-1)))
+      cascade(wheel.tv4, (wheel.base >> (TVR_BITS + 2*TVN_BITS)) & (TVN_SIZE-1));
+    wheel.base++;
+
+    struct timer *t;
+    while((t = wheel.tv1[idx]) != 0){
+      struct proc *p = t->proc;
+      unlink(t); // t may be gone once p runs
+      fire(p);
+    }
+  }
+}
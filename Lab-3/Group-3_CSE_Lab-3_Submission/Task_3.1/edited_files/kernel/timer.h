@@ -0,0 +1,17 @@
+// Task 3.1: hierarchical timer wheel for sleep timeouts.
+#define TVR_BITS  8                     // level 0: one slot per tick
+#define TVN_BITS  6                     // levels 1-3
+#define TVR_SIZE  (1 << TVR_BITS)
+#define TVN_SIZE  (1 << TVN_BITS)
+
+struct timer {
+  uint expires;          // tick at which it fires
+  struct proc *proc;     // process to wake
+  struct timer *next;    // next timer in the same slot
+  struct timer **pprev;  // link that points at us, 0 if not pending
+};
+
+void timer_add(struct timer *t, uint expires); // tickslock held
+void timer_del(struct timer *t);               // tickslock held
+void timer_tick(void);                         // clockintr(), tickslock held
+#define timer_expired(t) ((t)->pprev == 0)
@@ -0,0 +1,2 @@
+// Task 3.1: waitpid() options
+#define WNOHANG 0x1   // return 0 instead of blocking if the child is still running
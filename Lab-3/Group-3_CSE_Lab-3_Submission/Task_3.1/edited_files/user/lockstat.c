@@ -0,0 +1,50 @@
+// Task 3.1: dump the kernel's spinlock statistics.
+// usage: lockstat [-r]   (-r zeroes the counters afterwards)
+// One line per lock name: acquisitions, how many had to wait, the
+// total and average wait, and the longest time the lock was held.
+// The most contended locks come first.
+#include "kernel/types.h"
+#include "kernel/lockstat.h"
+#include "user/user.h"
+
+static struct lockstat st[NLOCKSTAT];
+
+int
+main(int argc, char *argv[])
+{
+  int reset = argc > 1 && strcmp(argv[1], "-r") == 0;
+
+  if(argc > 1 && !reset){
+    fprintf(2, "usage: lockstat [-r]\n");
+    exit(1);
+  }
+
+  int n = lockstats(st, NLOCKSTAT, reset);
+  if(n < 0){
+    fprintf(2, "lockstat: lockstats failed\n");
+    exit(1);
+  }
+
+  // most spin time first.
+  for(int i = 1; i < n; i++){
+    struct lockstat x = st[i];
+    int j = i;
+    for(; j > 0 && st[j-1].spincycles < x.spincycles; j--)
+      st[j] = st[j-1];
+    st[j] = x;
+  }
+
+  printf("LOCK\t\tACQUIRES\tWAITED\tSPINus\tAVGns\tMAXHOLDus\n");
+  for(int i = 0; i < n; i++){
+    struct lockstat *s = &st[i];
+    if(s->acquires == 0)
+      continue;
+    printf("%s%s\t%d\t\t%d\t%d\t%d\t%d\n", s->name, strlen(s->name) < 8 ? "\t" : "",
+           (int)s->acquires, (int)s->contended, (int)(s->spincycles / 10),
+           s->contended ? (int)(s->spincycles * 100 / s->contended) : 0,
+           (int)(s->maxhold / 10)); // 10 time CSR cycles a microsecond
+  }
+  if(reset)
+    printf("counters reset\n");
+  exit(0);
+}
@@ -0,0 +1,294 @@
+// Task 3.1: sampling profiler front end.
+// usage: prof [-f] [-r hz] cmd [args...]
+// Runs cmd with the kernel profiler on (every clock tick, or hz
+// samples a second on each CPU), then looks the samples up in
+// kernel.sym and user.sym, which the Makefile puts in the file
+// system, and prints a flat profile by function. user.sym holds
+// every program's table after a line "@<program>"; a process is
+// matched by its name, which exec() cuts to 15 characters. With -f it
+// prints folded stacks ("process;mode;function count") instead,
+// one per line, ready for flamegraph.pl.
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/wait.h"
+#include "kernel/prof.h"
+#include "user/user.h"
+
+#define MAXFILES   64     // symbol tables: the kernel and each program
+#define MAXENTRY   512    // distinct (process, mode, function) triples
+
+struct sym {
+  uint64 addr;
+  char *name;
+};
+
+// a program's (or the kernel's) symbol table, sorted by address.
+static struct symfile {
+  char name[16];
+  struct sym *syms;
+  int nsym;
+} files[MAXFILES];
+static int nfiles;
+static int loaded;
+
+static struct entry {
+  char proc[16];
+  int user;
+  char *fn;
+  int count;
+} entries[MAXENTRY];
+static int nentries;
+static int total, overflow;
+
+static struct profsample buf[64];
+
+// objdump -t also lists files, sections and mapping symbols;
+// only keep names that look like functions or data.
+static int
+wanted(char *name)
+{
+  int n = strlen(name);
+  if(n == 0 || name[0] == '.' || name[0] == '$')
+    return 0;
+  if(n > 2 && name[n-2] == '.' && (name[n-1] == 'c' || name[n-1] == 'S' || name[n-1] == 'o'))
+    return 0;
+  return 1;
+}
+
+static uint64
+hex(char *s)
+{
+  uint64 x = 0;
+  for(; *s; s++){
+    if(*s >= '0' && *s <= '9')
+      x = x * 16 + *s - '0';
+    else if(*s >= 'a' && *s <= 'f')
+      x = x * 16 + *s - 'a' + 10;
+    else
+      break;
+  }
+  return x;
+}
+
+// Start a table for program name, cut like exec() cuts p->name.
+static struct symfile*
+newfile(char *name, struct sym *syms)
+{
+  struct symfile *f;
+  int i;
+
+  if(nfiles == MAXFILES)
+    return 0;
+  f = &files[nfiles++];
+  for(i = 0; i < sizeof(f->name) - 1 && name[i]; i++)
+    f->name[i] = name[i];
+  f->name[i] = 0;
+  f->syms = syms;
+  f->nsym = 0;
+  return f;
+}
+
+static void
+sortsyms(struct symfile *f)
+{
+  // insertion sort: the tables are a few hundred lines, mostly in order.
+  for(int i = 1; i < f->nsym; i++){
+    struct sym x = f->syms[i];
+    int j = i;
+    for(; j > 0 && f->syms[j-1].addr > x.addr; j--)
+      f->syms[j] = f->syms[j-1];
+    f->syms[j] = x;
+  }
+}
+
+// Load the symbol file name (e.g. "kernel.sym"). Lines are
+// "<16 hex digits> <symbol>". Lines before the first "@<program>"
+// line go in a table called deflt, or are skipped if deflt is 0.
+static void
+loadsyms(char *name, char *deflt)
+{
+  struct stat st;
+  struct symfile *f = 0;
+  struct sym *syms;
+  int fd, n, off;
+  char *text;
+
+  if((fd = open(name, O_RDONLY)) < 0)
+    return;
+  if(fstat(fd, &st) < 0 || (text = malloc(st.size + 1)) == 0){
+    close(fd);
+    return;
+  }
+  for(off = 0; off < st.size && (n = read(fd, text + off, st.size - off)) > 0; off += n)
+    ;
+  close(fd);
+  text[off] = 0;
+
+  int lines = 0;
+  for(char *s = text; *s; s++)
+    if(*s == '\n')
+      lines++;
+  if((syms = malloc((lines + 1) * sizeof(struct sym))) == 0)
+    return;
+  if(deflt)
+    f = newfile(deflt, syms);
+
+  char *s = text;
+  while(*s){
+    char *nl = strchr(s, '\n');
+    if(nl)
+      *nl = 0;
+    if(s[0] == '@'){
+      if(f){
+        sortsyms(f);
+        syms = f->syms + f->nsym;
+      }
+      if((f = newfile(s + 1, syms)) == 0)
+        return;
+    } else if(f && strlen(s) > 17 && s[16] == ' ' && wanted(s + 17)){
+      f->syms[f->nsym].addr = hex(s);
+      f->syms[f->nsym].name = s + 17;
+      f->nsym++;
+    }
+    if(nl == 0)
+      break;
+    s = nl + 1;
+  }
+  if(f)
+    sortsyms(f);
+}
+
+// The function containing pc in the symbols of prog, or "?".
+static char*
+lookup(char *prog, uint64 pc)
+{
+  struct symfile *f = 0;
+
+  if(!loaded){
+    loaded = 1;
+    loadsyms("kernel.sym", "kernel");
+    loadsyms("user.sym", 0);
+  }
+  for(int i = 0; i < nfiles; i++)
+    if(strcmp(files[i].name, prog) == 0)
+      f = &files[i];
+  if(f == 0)
+    return "?";
+
+  // last symbol at or below pc.
+  int lo = 0, hi = f->nsym - 1, best = -1;
+  while(lo <= hi){
+    int mid = (lo + hi) / 2;
+    if(f->syms[mid].addr <= pc){
+      best = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return best < 0 ? "?" : f->syms[best].name;
+}
+
+static void
+count(struct profsample *s)
+{
+  char *proc = s->pid ? s->name : "idle";
+  char *fn = lookup(s->user ? s->name : "kernel", s->pc);
+
+  total++;
+  for(int i = 0; i < nentries; i++){
+    struct entry *e = &entries[i];
+    if(e->fn == fn && e->user == s->user && strcmp(e->proc, proc) == 0){
+      e->count++;
+      return;
+    }
+  }
+  if(nentries == MAXENTRY){
+    overflow++;
+    return;
+  }
+  struct entry *e = &entries[nentries++];
+  strcpy(e->proc, proc);
+  e->user = s->user;
+  e->fn = fn;
+  e->count = 1;
+}
+
+static void
+drain(void)
+{
+  int n;
+  while((n = prof_read(buf, sizeof(buf) / sizeof(buf[0]))) > 0)
+    for(int i = 0; i < n; i++)
+      count(&buf[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int folded = 0, hz = 0;
+  int i;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-f") == 0)
+      folded = 1;
+    else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      hz = atoi(argv[++i]);
+    else
+      break;
+  }
+  if(i >= argc){
+    fprintf(2, "usage: prof [-f] [-r hz] cmd [args...]\n");
+    exit(1);
+  }
+
+  if(prof_start(hz) < 0){
+    fprintf(2, "prof: bad rate %d (at most %d)\n", hz, PROF_MAXHZ);
+    exit(1);
+  }
+  int pid = fork();
+  if(pid < 0){
+    prof_stop();
+    fprintf(2, "prof: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[i], argv + i);
+    fprintf(2, "prof: exec %s failed\n", argv[i]);
+    exit(1);
+  }
+
+  // empty the rings every tick while cmd runs, so they don't fill.
+  while(waitpid(pid, 0, WNOHANG) == 0){
+    drain();
+    pause(1);
+  }
+  int dropped = prof_stop();
+  drain();
+
+  if(folded){
+    for(int j = 0; j < nentries; j++)
+      printf("%s;%s;%s %d\n", entries[j].proc, entries[j].user ? "user" : "kernel",
+             entries[j].fn, entries[j].count);
+    exit(0);
+  }
+
+  // flat profile, most samples first.
+  for(int j = 1; j < nentries; j++){
+    struct entry x = entries[j];
+    int k = j;
+    for(; k > 0 && entries[k-1].count < x.count; k--)
+      entries[k] = entries[k-1];
+    entries[k] = x;
+  }
+  printf("%d samples, %d dropped", total, dropped);
+  if(overflow)
+    printf(", %d in functions not listed", overflow);
+  printf("\n");
+  printf("COUNT\t%%\tMODE\tPROCESS\tFUNCTION\n");
+  for(int j = 0; j < nentries; j++)
+    printf("%d\t%d\t%s\t%s\t%s\n", entries[j].count, entries[j].count * 100 / total,
+           entries[j].user ? "user" : "kernel", entries[j].proc, entries[j].fn);
+  exit(0);
+}
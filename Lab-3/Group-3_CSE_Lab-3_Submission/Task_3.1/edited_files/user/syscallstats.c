@@ -0,0 +1,98 @@
+// Task 3.1: dump the kernel's per-syscall statistics.
+// usage: syscallstats [-r]   (-r zeroes the counters afterwards)
+// For each syscall that was called: calls, total and average time,
+// and the median and 99th percentile latency, rounded up to the
+// top of their log2 histogram bucket.
+#include "kernel/types.h"
+#include "kernel/syscall.h"
+#include "kernel/syscallstat.h"
+#include "user/user.h"
+
+static char *names[SYSST_NSYS] = {
+[SYS_fork]    "fork",
+[SYS_exit]    "exit",
+[SYS_wait]    "wait",
+[SYS_pipe]    "pipe",
+[SYS_read]    "read",
+[SYS_kill]    "kill",
+[SYS_exec]    "exec",
+[SYS_fstat]   "fstat",
+[SYS_chdir]   "chdir",
+[SYS_dup]     "dup",
+[SYS_getpid]  "getpid",
+[SYS_sbrk]    "sbrk",
+[SYS_pause]   "pause",
+[SYS_uptime]  "uptime",
+[SYS_open]    "open",
+[SYS_write]   "write",
+[SYS_mknod]   "mknod",
+[SYS_unlink]  "unlink",
+[SYS_link]    "link",
+[SYS_mkdir]   "mkdir",
+[SYS_close]   "close",
+[SYS_shm_create]       "shm_create",
+[SYS_shm_get]          "shm_get",
+[SYS_shm_close]        "shm_close",
+[SYS_mbox_create]      "mbox_create",
+[SYS_mbox_send]        "mbox_send",
+[SYS_mbox_recv]        "mbox_recv",
+[SYS_mbox_close]       "mbox_close",
+[SYS_mbox_bind_server] "mbox_bind_server",
+[SYS_yield_to]         "yield_to",
+[SYS_waitpid]          "waitpid",
+[SYS_setgang]          "setgang",
+[SYS_prof_start]       "prof_start",
+[SYS_prof_stop]        "prof_stop",
+[SYS_prof_read]        "prof_read",
+[SYS_syscallstats]     "syscallstats",
+[SYS_lockstats]        "lockstats",
+};
+
+static struct syscallstat st[SYSST_NSYS];
+
+// microseconds at the top of the bucket holding the p-th percentile.
+static int
+percentile(struct syscallstat *s, int p)
+{
+  uint64 want = (s->count * p + 99) / 100;
+  uint64 seen = 0;
+  int b;
+
+  for(b = 0; b < SYSST_NLAT - 1; b++){
+    seen += s->lat[b];
+    if(seen >= want)
+      break;
+  }
+  return (int)((2ULL << b) / 10); // 10 time CSR cycles a microsecond
+}
+
+int
+main(int argc, char *argv[])
+{
+  int reset = argc > 1 && strcmp(argv[1], "-r") == 0;
+
+  if(argc > 1 && !reset){
+    fprintf(2, "usage: syscallstats [-r]\n");
+    exit(1);
+  }
+
+  int n = syscallstats(st, SYSST_NSYS, reset);
+  if(n < 0){
+    fprintf(2, "syscallstats: syscallstats failed\n");
+    exit(1);
+  }
+
+  printf("SYSCALL\t\tCALLS\tTOTALms\tAVGus\tP50us\tP99us\n");
+  for(int i = 1; i < n; i++){
+    struct syscallstat *s = &st[i];
+    if(s->count == 0)
+      continue;
+    char *name = names[i] ? names[i] : "?";
+    printf("%s%s\t%d\t%d\t%d\t%d\t%d\n", name, strlen(name) < 8 ? "\t" : "",
+           (int)s->count, (int)(s->cycles / 10000), (int)(s->cycles / s->count / 10),
+           percentile(s, 50), percentile(s, 99));
+  }
+  if(reset)
+    printf("counters reset\n");
+  exit(0);
+}
@@ -1,60 +1,72 @@
-#define SBRK_ERROR ((char *)-1)
-
-struct stat;
-
-// system calls
-int fork(void);
-int exit(int) __attribute__((noreturn));
-int wait(int*);
-int pipe(int*);
-int write(int, const void*, int);
-int read(int, void*, int);
-int close(int);
-int kill(int);
-int exec(const char*, char**);
-int open(const char*, int);
-int mknod(const char*, short, short);
-int unlink(const char*);
-int fstat(int fd, struct stat*);
-int link(const char*, const char*);
-int mkdir(const char*);
-int chdir(const char*);
-int dup(int);
-int getpid(void);
-char* sys_sbrk(int,int);
-int pause(int);
-int uptime(void);
-
-// ulib.c
-int stat(const char*, struct stat*);
-char* strcpy(char*, const char*);
-void *memmove(void*, const void*, int);
-char* strchr(const char*, char c);
-int strcmp(const char*, const char*);
-char* gets(char*, int max);
-uint strlen(const char*);
-void* memset(void*, int, uint);
-int atoi(const char*);
-void itoa10(int x, char *s);
-int memcmp(const void *, const void *, uint);
-void *memcpy(void *, const void *, uint);
-char* sbrk(int);
-char* sbrklazy(int);
-
-// printf.c
-void fprintf(int, const char*, ...) __attribute__ ((format (printf, 2, 3)));
-void printf(const char*, ...) __attribute__ ((format (printf, 1, 2)));
-
-// umalloc.c
-void* malloc(uint);
-void free(void*);
-
-// Task 3.1
-int   shm_create(int key);
-void* shm_get(int key);
-int   shm_close(int key);
-
-int   mbox_create(int key);
-int   mbox_send(int id, int msg);
-int   mbox_recv(int id, int *msg);
-int   mbox_close(int id);
\ No newline at end of file
+#define SBRK_ERROR ((char *)-1)
+
+struct stat;
+
+// system calls
+int fork(void);
+int exit(int) __attribute__((noreturn));
+int wait(int*);
+int pipe(int*);
+int write(int, const void*, int);
+int read(int, void*, int);
+int close(int);
+int kill(int);
+int exec(const char*, char**);
+int open(const char*, int);
+int mknod(const char*, short, short);
+int unlink(const char*);
+int fstat(int fd, struct stat*);
+int link(const char*, const char*);
+int mkdir(const char*);
+int chdir(const char*);
+int dup(int);
+int getpid(void);
+char* sys_sbrk(int,int);
+int pause(int);
+int uptime(void);
+
+// ulib.c
+int stat(const char*, struct stat*);
+char* strcpy(char*, const char*);
+void *memmove(void*, const void*, int);
+char* strchr(const char*, char c);
+int strcmp(const char*, const char*);
+char* gets(char*, int max);
+uint strlen(const char*);
+void* memset(void*, int, uint);
+int atoi(const char*);
+void itoa10(int x, char *s);
+int memcmp(const void *, const void *, uint);
+void *memcpy(void *, const void *, uint);
+char* sbrk(int);
+char* sbrklazy(int);
+
+// printf.c
+void fprintf(int, const char*, ...) __attribute__ ((format (printf, 2, 3)));
+void printf(const char*, ...) __attribute__ ((format (printf, 1, 2)));
+
+// umalloc.c
+void* malloc(uint);
+void free(void*);
+
+// Task 3.1
+int   shm_create(int key);
+void* shm_get(int key);
+int   shm_close(int key);
+
+int   mbox_create(int key);
+int   mbox_send(int id, int msg);
+int   mbox_recv(int id, int *msg);
+int   mbox_close(int id);
+int   mbox_bind_server(int id);
+int   yield_to(int pid);
+int   waitpid(int pid, int *status, int options);
+int   setgang(int gid);
+struct profsample;
+int   prof_start(int hz);
+int   prof_stop(void);
+int   prof_read(struct profsample *buf, int n);
+struct syscallstat;
+int   syscallstats(struct syscallstat *buf, int n, int reset);
+struct lockstat;
+int   lockstats(struct lockstat *buf, int n, int reset);
\ No newline at end of file
@@ -1,54 +1,63 @@
-#!/usr/bin/perl -w
-
-# Generate usys.S, the stubs for syscalls.
-
-print "# generated by usys.pl - do not edit\n";
-
-print "#include \"kernel/syscall.h\"\n";
-
-sub entry {
-    my $prefix = "sys_";
-    my $name = shift;
-    if ($name eq "sbrk") {
-	print ".global $prefix$name\n";
-	print "$prefix$name:\n";
-    } else {
-	print ".global $name\n";
-	print "$name:\n";
-    }
-    print " li a7, SYS_${name}\n";
-    print " ecall\n";
-    print " ret\n";
-}
-	
-entry("fork");
-entry("exit");
-entry("wait");
-entry("pipe");
-entry("read");
-entry("write");
-entry("close");
-entry("kill");
-entry("exec");
-entry("open");
-entry("mknod");
-entry("unlink");
-entry("fstat");
-entry("link");
-entry("mkdir");
-entry("chdir");
-entry("dup");
-entry("getpid");
-entry("sbrk");
-entry("pause");
-entry("uptime");
-
-# Task 3.1
-entry("shm_create");
-entry("shm_get");
-entry("shm_close");
-
-entry("mbox_create");
-entry("mbox_send");
-entry("mbox_recv");
-entry("mbox_close");
\ No newline at end of file
+#!/usr/bin/perl -w
+
+# Generate usys.S, the stubs for syscalls.
+
+print "# generated by usys.pl - do not edit\n";
+
+print "#include \"kernel/syscall.h\"\n";
+
+sub entry {
+    my $prefix = "sys_";
+    my $name = shift;
+    if ($name eq "sbrk") {
+	print ".global $prefix$name\n";
+	print "$prefix$name:\n";
+    } else {
+	print ".global $name\n";
+	print "$name:\n";
+    }
+    print " li a7, SYS_${name}\n";
+    print " ecall\n";
+    print " ret\n";
+}
+	
+entry("fork");
+entry("exit");
+entry("wait");
+entry("pipe");
+entry("read");
+entry("write");
+entry("close");
+entry("kill");
+entry("exec");
+entry("open");
+entry("mknod");
+entry("unlink");
+entry("fstat");
+entry("link");
+entry("mkdir");
+entry("chdir");
+entry("dup");
+entry("getpid");
+entry("sbrk");
+entry("pause");
+entry("uptime");
+
+# Task 3.1
+entry("shm_create");
+entry("shm_get");
+entry("shm_close");
+
+entry("mbox_create");
+entry("mbox_send");
+entry("mbox_recv");
+entry("mbox_close");
+entry("mbox_bind_server");
+entry("yield_to");
+entry("waitpid");
+entry("setgang");
+entry("prof_start");
+entry("prof_stop");
+entry("prof_read");
+entry("syscallstats");
+entry("lockstats");
\ No newline at end of file